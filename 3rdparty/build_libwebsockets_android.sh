@@ -251,6 +251,7 @@ build_abi() {
         -DCMAKE_C_FLAGS="-Wno-sign-conversion" \
         -DCMAKE_CXX_FLAGS="-Wno-sign-conversion" \
         -DLWS_WITH_SSL=${ENABLE_SSL} \
+        -DLWS_WITH_TLS_SESSIONS=ON \
         -DLWS_WITH_MBEDTLS=ON \
         -DLWS_MBEDTLS_LIBRARIES="${MBEDTLS_OUTPUT_DIR}/lib/libmbedtls.a;${MBEDTLS_OUTPUT_DIR}/lib/libmbedx509.a;${MBEDTLS_OUTPUT_DIR}/lib/libmbedcrypto.a" \
         -DLWS_MBEDTLS_INCLUDE_DIRS="${MBEDTLS_OUTPUT_DIR}/include" \
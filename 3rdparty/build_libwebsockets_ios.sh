@@ -365,6 +365,7 @@ build_lws_platform() {
         -DCMAKE_CXX_FLAGS="${CMAKE_CXX_FLAGS}" \
         ${CMAKE_SSL_OPTIONS} \
         -DLWS_WITH_SSL=${ENABLE_SSL} \
+        -DLWS_WITH_TLS_SESSIONS=ON \
         -DLWS_WITH_SHARED=OFF \
         -DLWS_WITH_STATIC=ON \
         -DLWS_WITHOUT_TESTAPPS=ON \
@@ -0,0 +1,591 @@
+#include "BinaryCodec.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace margelo::nitro::realtimenitro {
+
+namespace {
+
+// Largest integer a JS number can hold exactly (2^53)
+constexpr double MAX_SAFE_INTEGER = 9007199254740992.0;
+
+// ============================================================
+// Byte reader (big-endian, bounds-checked)
+// ============================================================
+
+struct Reader {
+  const uint8_t* pos;
+  const uint8_t* end;
+
+  // Lengths come straight from the wire: compare in 64 bits so they
+  // cannot wrap when narrowed to a 32-bit size_t
+  void need(uint64_t n) const {
+    if (static_cast<uint64_t>(end - pos) < n) {
+      throw std::runtime_error("Truncated frame");
+    }
+  }
+
+  // `count` items of at least `itemBytes` each, without multiplying
+  void needItems(uint64_t count, uint64_t itemBytes) const {
+    if (static_cast<uint64_t>(end - pos) / itemBytes < count) {
+      throw std::runtime_error("Truncated frame");
+    }
+  }
+
+  uint8_t u8() {
+    need(1);
+    return *pos++;
+  }
+
+  uint16_t u16() {
+    need(2);
+    uint16_t v = static_cast<uint16_t>((pos[0] << 8) | pos[1]);
+    pos += 2;
+    return v;
+  }
+
+  uint32_t u32() {
+    need(4);
+    uint32_t v = (static_cast<uint32_t>(pos[0]) << 24) |
+                 (static_cast<uint32_t>(pos[1]) << 16) |
+                 (static_cast<uint32_t>(pos[2]) << 8) |
+                 static_cast<uint32_t>(pos[3]);
+    pos += 4;
+    return v;
+  }
+
+  uint64_t u64() {
+    uint64_t hi = u32();
+    uint64_t lo = u32();
+    return (hi << 32) | lo;
+  }
+
+  float f32() {
+    uint32_t bits = u32();
+    float v;
+    std::memcpy(&v, &bits, sizeof(v));
+    return v;
+  }
+
+  double f64() {
+    uint64_t bits = u64();
+    double v;
+    std::memcpy(&v, &bits, sizeof(v));
+    return v;
+  }
+
+  const uint8_t* take(uint64_t n) {
+    need(n);
+    const uint8_t* start = pos;
+    pos += n;
+    return start;
+  }
+};
+
+// ============================================================
+// Byte writer (big-endian)
+// ============================================================
+
+struct Writer {
+  std::vector<uint8_t> out;
+
+  void u8(uint8_t v) { out.push_back(v); }
+
+  void u16(uint16_t v) {
+    out.push_back(static_cast<uint8_t>(v >> 8));
+    out.push_back(static_cast<uint8_t>(v));
+  }
+
+  void u32(uint32_t v) {
+    for (int shift = 24; shift >= 0; shift -= 8) {
+      out.push_back(static_cast<uint8_t>(v >> shift));
+    }
+  }
+
+  void u64(uint64_t v) {
+    for (int shift = 56; shift >= 0; shift -= 8) {
+      out.push_back(static_cast<uint8_t>(v >> shift));
+    }
+  }
+
+  void f64(double v) {
+    uint64_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    u64(bits);
+  }
+
+  void bytes(const void* data, size_t size) {
+    auto* p = static_cast<const uint8_t*>(data);
+    out.insert(out.end(), p, p + size);
+  }
+};
+
+// ============================================================
+// Shared helpers
+// ============================================================
+
+AnyValue integerValue(int64_t v) {
+  double d = static_cast<double>(v);
+  if (std::fabs(d) <= MAX_SAFE_INTEGER) {
+    return AnyValue(d);
+  }
+  return AnyValue(v);
+}
+
+AnyValue unsignedValue(uint64_t v) {
+  if (v <= static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) {
+    return integerValue(static_cast<int64_t>(v));
+  }
+  // Beyond int64: only representable (lossily) as a double
+  return AnyValue(static_cast<double>(v));
+}
+
+AnyValue bytesValue(const uint8_t* data, size_t size) {
+  AnyArray array;
+  array.reserve(size);
+  for (size_t i = 0; i < size; i++) {
+    array.emplace_back(static_cast<double>(data[i]));
+  }
+  return AnyValue(std::move(array));
+}
+
+std::string keyToString(const AnyValue& key) {
+  if (std::holds_alternative<std::string>(key)) {
+    return std::get<std::string>(key);
+  }
+  if (std::holds_alternative<double>(key)) {
+    double d = std::get<double>(key);
+    if (std::trunc(d) == d && std::fabs(d) <= MAX_SAFE_INTEGER) {
+      return std::to_string(static_cast<int64_t>(d));
+    }
+    return std::to_string(d);
+  }
+  if (std::holds_alternative<int64_t>(key)) {
+    return std::to_string(std::get<int64_t>(key));
+  }
+  if (std::holds_alternative<bool>(key)) {
+    return std::get<bool>(key) ? "true" : "false";
+  }
+  return "null";
+}
+
+std::shared_ptr<AnyMap> toAnyMap(AnyValue&& root) {
+  if (!std::holds_alternative<AnyObject>(root)) {
+    throw std::runtime_error("Top-level value must be a map");
+  }
+  auto map = AnyMap::make();
+  map->getMap() = std::move(std::get<AnyObject>(root));
+  return map;
+}
+
+void checkDepth(int depth, int maxDepth) {
+  if (depth > maxDepth) {
+    throw std::runtime_error("Nesting too deep");
+  }
+}
+
+// ============================================================
+// MessagePack
+// ============================================================
+
+AnyValue readMsgPack(Reader& r, int depth, int maxDepth);
+
+AnyValue readMsgPackArray(Reader& r, uint32_t count, int depth, int maxDepth) {
+  AnyArray array;
+  // Every element takes at least one byte, so never trust count blindly
+  r.need(count);
+  array.reserve(count);
+  for (uint32_t i = 0; i < count; i++) {
+    array.push_back(readMsgPack(r, depth + 1, maxDepth));
+  }
+  return AnyValue(std::move(array));
+}
+
+AnyValue readMsgPackMap(Reader& r, uint32_t count, int depth, int maxDepth) {
+  AnyObject object;
+  r.needItems(count, 2);
+  object.reserve(count);
+  for (uint32_t i = 0; i < count; i++) {
+    std::string key = keyToString(readMsgPack(r, depth + 1, maxDepth));
+    object[std::move(key)] = readMsgPack(r, depth + 1, maxDepth);
+  }
+  return AnyValue(std::move(object));
+}
+
+AnyValue readMsgPackExt(Reader& r, uint32_t size) {
+  auto type = static_cast<int8_t>(r.u8());
+  const uint8_t* data = r.take(size);
+  AnyObject ext;
+  ext["type"] = AnyValue(static_cast<double>(type));
+  ext["data"] = bytesValue(data, size);
+  return AnyValue(std::move(ext));
+}
+
+AnyValue readMsgPackString(Reader& r, uint32_t size) {
+  const uint8_t* data = r.take(size);
+  return AnyValue(std::string(reinterpret_cast<const char*>(data), size));
+}
+
+AnyValue readMsgPack(Reader& r, int depth, int maxDepth) {
+  checkDepth(depth, maxDepth);
+  uint8_t b = r.u8();
+
+  if (b <= 0x7f) return AnyValue(static_cast<double>(b));
+  if (b >= 0xe0) return AnyValue(static_cast<double>(static_cast<int8_t>(b)));
+  if ((b & 0xf0) == 0x80) return readMsgPackMap(r, b & 0x0f, depth, maxDepth);
+  if ((b & 0xf0) == 0x90) return readMsgPackArray(r, b & 0x0f, depth, maxDepth);
+  if ((b & 0xe0) == 0xa0) return readMsgPackString(r, b & 0x1f);
+
+  switch (b) {
+    case 0xc0: return AnyValue();
+    case 0xc2: return AnyValue(false);
+    case 0xc3: return AnyValue(true);
+    case 0xc4: { uint32_t n = r.u8(); return bytesValue(r.take(n), n); }
+    case 0xc5: { uint32_t n = r.u16(); return bytesValue(r.take(n), n); }
+    case 0xc6: { uint32_t n = r.u32(); return bytesValue(r.take(n), n); }
+    case 0xc7: return readMsgPackExt(r, r.u8());
+    case 0xc8: return readMsgPackExt(r, r.u16());
+    case 0xc9: return readMsgPackExt(r, r.u32());
+    case 0xca: return AnyValue(static_cast<double>(r.f32()));
+    case 0xcb: return AnyValue(r.f64());
+    case 0xcc: return AnyValue(static_cast<double>(r.u8()));
+    case 0xcd: return AnyValue(static_cast<double>(r.u16()));
+    case 0xce: return AnyValue(static_cast<double>(r.u32()));
+    case 0xcf: return unsignedValue(r.u64());
+    case 0xd0: return AnyValue(static_cast<double>(static_cast<int8_t>(r.u8())));
+    case 0xd1: return AnyValue(static_cast<double>(static_cast<int16_t>(r.u16())));
+    case 0xd2: return AnyValue(static_cast<double>(static_cast<int32_t>(r.u32())));
+    case 0xd3: return integerValue(static_cast<int64_t>(r.u64()));
+    case 0xd4: return readMsgPackExt(r, 1);
+    case 0xd5: return readMsgPackExt(r, 2);
+    case 0xd6: return readMsgPackExt(r, 4);
+    case 0xd7: return readMsgPackExt(r, 8);
+    case 0xd8: return readMsgPackExt(r, 16);
+    case 0xd9: return readMsgPackString(r, r.u8());
+    case 0xda: return readMsgPackString(r, r.u16());
+    case 0xdb: return readMsgPackString(r, r.u32());
+    case 0xdc: return readMsgPackArray(r, r.u16(), depth, maxDepth);
+    case 0xdd: return readMsgPackArray(r, r.u32(), depth, maxDepth);
+    case 0xde: return readMsgPackMap(r, r.u16(), depth, maxDepth);
+    case 0xdf: return readMsgPackMap(r, r.u32(), depth, maxDepth);
+    default:
+      throw std::runtime_error("Invalid MessagePack type byte");
+  }
+}
+
+void writeMsgPackInt(Writer& w, int64_t v) {
+  if (v >= 0) {
+    if (v <= 0x7f) { w.u8(static_cast<uint8_t>(v)); }
+    else if (v <= 0xff) { w.u8(0xcc); w.u8(static_cast<uint8_t>(v)); }
+    else if (v <= 0xffff) { w.u8(0xcd); w.u16(static_cast<uint16_t>(v)); }
+    else if (v <= 0xffffffffLL) { w.u8(0xce); w.u32(static_cast<uint32_t>(v)); }
+    else { w.u8(0xcf); w.u64(static_cast<uint64_t>(v)); }
+  } else {
+    if (v >= -32) { w.u8(static_cast<uint8_t>(v)); }
+    else if (v >= -128) { w.u8(0xd0); w.u8(static_cast<uint8_t>(v)); }
+    else if (v >= -32768) { w.u8(0xd1); w.u16(static_cast<uint16_t>(v)); }
+    else if (v >= -2147483648LL) { w.u8(0xd2); w.u32(static_cast<uint32_t>(v)); }
+    else { w.u8(0xd3); w.u64(static_cast<uint64_t>(v)); }
+  }
+}
+
+void writeMsgPackString(Writer& w, const std::string& s) {
+  size_t n = s.size();
+  if (n <= 31) { w.u8(static_cast<uint8_t>(0xa0 | n)); }
+  else if (n <= 0xff) { w.u8(0xd9); w.u8(static_cast<uint8_t>(n)); }
+  else if (n <= 0xffff) { w.u8(0xda); w.u16(static_cast<uint16_t>(n)); }
+  else { w.u8(0xdb); w.u32(static_cast<uint32_t>(n)); }
+  w.bytes(s.data(), n);
+}
+
+void writeMsgPack(Writer& w, const AnyValue& v, int depth, int maxDepth);
+
+void writeMsgPackObject(Writer& w, const AnyObject& object, int depth, int maxDepth) {
+  size_t n = object.size();
+  if (n <= 15) { w.u8(static_cast<uint8_t>(0x80 | n)); }
+  else if (n <= 0xffff) { w.u8(0xde); w.u16(static_cast<uint16_t>(n)); }
+  else { w.u8(0xdf); w.u32(static_cast<uint32_t>(n)); }
+  for (const auto& [key, value] : object) {
+    writeMsgPackString(w, key);
+    writeMsgPack(w, value, depth + 1, maxDepth);
+  }
+}
+
+void writeMsgPack(Writer& w, const AnyValue& v, int depth, int maxDepth) {
+  checkDepth(depth, maxDepth);
+
+  if (std::holds_alternative<bool>(v)) {
+    w.u8(std::get<bool>(v) ? 0xc3 : 0xc2);
+  } else if (std::holds_alternative<double>(v)) {
+    double d = std::get<double>(v);
+    if (std::trunc(d) == d && std::fabs(d) <= MAX_SAFE_INTEGER) {
+      writeMsgPackInt(w, static_cast<int64_t>(d));
+    } else {
+      w.u8(0xcb);
+      w.f64(d);
+    }
+  } else if (std::holds_alternative<int64_t>(v)) {
+    writeMsgPackInt(w, std::get<int64_t>(v));
+  } else if (std::holds_alternative<std::string>(v)) {
+    writeMsgPackString(w, std::get<std::string>(v));
+  } else if (std::holds_alternative<AnyArray>(v)) {
+    const auto& array = std::get<AnyArray>(v);
+    size_t n = array.size();
+    if (n <= 15) { w.u8(static_cast<uint8_t>(0x90 | n)); }
+    else if (n <= 0xffff) { w.u8(0xdc); w.u16(static_cast<uint16_t>(n)); }
+    else { w.u8(0xdd); w.u32(static_cast<uint32_t>(n)); }
+    for (const auto& item : array) {
+      writeMsgPack(w, item, depth + 1, maxDepth);
+    }
+  } else if (std::holds_alternative<AnyObject>(v)) {
+    writeMsgPackObject(w, std::get<AnyObject>(v), depth, maxDepth);
+  } else {
+    w.u8(0xc0); // null
+  }
+}
+
+// ============================================================
+// CBOR
+// ============================================================
+
+constexpr uint8_t CBOR_BREAK = 0xff;
+
+uint64_t readCborArgument(Reader& r, uint8_t info) {
+  if (info < 24) return info;
+  switch (info) {
+    case 24: return r.u8();
+    case 25: return r.u16();
+    case 26: return r.u32();
+    case 27: return r.u64();
+    default:
+      throw std::runtime_error("Invalid CBOR additional info");
+  }
+}
+
+double halfToDouble(uint16_t half) {
+  int exponent = (half >> 10) & 0x1f;
+  int mantissa = half & 0x3ff;
+  double value;
+  if (exponent == 0) {
+    value = std::ldexp(mantissa, -24);
+  } else if (exponent != 31) {
+    value = std::ldexp(mantissa + 1024, exponent - 25);
+  } else {
+    value = mantissa == 0 ? std::numeric_limits<double>::infinity()
+                          : std::numeric_limits<double>::quiet_NaN();
+  }
+  return (half & 0x8000) ? -value : value;
+}
+
+// Reads a (possibly indefinite-length) byte or text string
+std::string readCborChunks(Reader& r, uint8_t major, uint8_t info) {
+  if (info != 31) {
+    uint64_t n = readCborArgument(r, info);
+    const uint8_t* data = r.take(n);
+    return std::string(reinterpret_cast<const char*>(data), static_cast<size_t>(n));
+  }
+  std::string result;
+  while (true) {
+    uint8_t b = r.u8();
+    if (b == CBOR_BREAK) break;
+    if ((b >> 5) != major || (b & 0x1f) == 31) {
+      throw std::runtime_error("Invalid CBOR string chunk");
+    }
+    uint64_t n = readCborArgument(r, b & 0x1f);
+    const uint8_t* data = r.take(n);
+    result.append(reinterpret_cast<const char*>(data), static_cast<size_t>(n));
+  }
+  return result;
+}
+
+bool atCborBreak(Reader& r) {
+  r.need(1);
+  if (*r.pos == CBOR_BREAK) {
+    r.pos++;
+    return true;
+  }
+  return false;
+}
+
+AnyValue readCbor(Reader& r, int depth, int maxDepth) {
+  checkDepth(depth, maxDepth);
+  uint8_t b = r.u8();
+  uint8_t major = b >> 5;
+  uint8_t info = b & 0x1f;
+
+  switch (major) {
+    case 0:
+      return unsignedValue(readCborArgument(r, info));
+    case 1: {
+      uint64_t n = readCborArgument(r, info);
+      if (n > static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) {
+        return AnyValue(-1.0 - static_cast<double>(n));
+      }
+      return integerValue(-1 - static_cast<int64_t>(n));
+    }
+    case 2: {
+      std::string bytes = readCborChunks(r, major, info);
+      return bytesValue(reinterpret_cast<const uint8_t*>(bytes.data()), bytes.size());
+    }
+    case 3:
+      return AnyValue(readCborChunks(r, major, info));
+    case 4: {
+      AnyArray array;
+      if (info == 31) {
+        while (!atCborBreak(r)) {
+          array.push_back(readCbor(r, depth + 1, maxDepth));
+        }
+      } else {
+        uint64_t n = readCborArgument(r, info);
+        r.need(n);
+        array.reserve(static_cast<size_t>(n));
+        for (uint64_t i = 0; i < n; i++) {
+          array.push_back(readCbor(r, depth + 1, maxDepth));
+        }
+      }
+      return AnyValue(std::move(array));
+    }
+    case 5: {
+      AnyObject object;
+      if (info == 31) {
+        while (!atCborBreak(r)) {
+          std::string key = keyToString(readCbor(r, depth + 1, maxDepth));
+          object[std::move(key)] = readCbor(r, depth + 1, maxDepth);
+        }
+      } else {
+        uint64_t n = readCborArgument(r, info);
+        r.needItems(n, 2);
+        object.reserve(static_cast<size_t>(n));
+        for (uint64_t i = 0; i < n; i++) {
+          std::string key = keyToString(readCbor(r, depth + 1, maxDepth));
+          object[std::move(key)] = readCbor(r, depth + 1, maxDepth);
+        }
+      }
+      return AnyValue(std::move(object));
+    }
+    case 6:
+      // Semantic tag: keep the tagged item, drop the tag
+      readCborArgument(r, info);
+      return readCbor(r, depth + 1, maxDepth);
+    default:
+      break;
+  }
+
+  // Major type 7: simple values and floats
+  switch (info) {
+    case 20: return AnyValue(false);
+    case 21: return AnyValue(true);
+    case 22:
+    case 23: return AnyValue();
+    case 25: return AnyValue(halfToDouble(r.u16()));
+    case 26: return AnyValue(static_cast<double>(r.f32()));
+    case 27: return AnyValue(r.f64());
+    default:
+      throw std::runtime_error("Unsupported CBOR simple value");
+  }
+}
+
+void writeCborHead(Writer& w, uint8_t major, uint64_t n) {
+  uint8_t m = static_cast<uint8_t>(major << 5);
+  if (n < 24) { w.u8(static_cast<uint8_t>(m | n)); }
+  else if (n <= 0xff) { w.u8(m | 24); w.u8(static_cast<uint8_t>(n)); }
+  else if (n <= 0xffff) { w.u8(m | 25); w.u16(static_cast<uint16_t>(n)); }
+  else if (n <= 0xffffffffULL) { w.u8(m | 26); w.u32(static_cast<uint32_t>(n)); }
+  else { w.u8(m | 27); w.u64(n); }
+}
+
+void writeCborInt(Writer& w, int64_t v) {
+  if (v >= 0) {
+    writeCborHead(w, 0, static_cast<uint64_t>(v));
+  } else {
+    writeCborHead(w, 1, static_cast<uint64_t>(-1 - v));
+  }
+}
+
+void writeCbor(Writer& w, const AnyValue& v, int depth, int maxDepth) {
+  checkDepth(depth, maxDepth);
+
+  if (std::holds_alternative<bool>(v)) {
+    w.u8(std::get<bool>(v) ? 0xf5 : 0xf4);
+  } else if (std::holds_alternative<double>(v)) {
+    double d = std::get<double>(v);
+    if (std::trunc(d) == d && std::fabs(d) <= MAX_SAFE_INTEGER) {
+      writeCborInt(w, static_cast<int64_t>(d));
+    } else {
+      w.u8(0xfb);
+      w.f64(d);
+    }
+  } else if (std::holds_alternative<int64_t>(v)) {
+    writeCborInt(w, std::get<int64_t>(v));
+  } else if (std::holds_alternative<std::string>(v)) {
+    const auto& s = std::get<std::string>(v);
+    writeCborHead(w, 3, s.size());
+    w.bytes(s.data(), s.size());
+  } else if (std::holds_alternative<AnyArray>(v)) {
+    const auto& array = std::get<AnyArray>(v);
+    writeCborHead(w, 4, array.size());
+    for (const auto& item : array) {
+      writeCbor(w, item, depth + 1, maxDepth);
+    }
+  } else if (std::holds_alternative<AnyObject>(v)) {
+    const auto& object = std::get<AnyObject>(v);
+    writeCborHead(w, 5, object.size());
+    for (const auto& [key, value] : object) {
+      writeCborHead(w, 3, key.size());
+      w.bytes(key.data(), key.size());
+      writeCbor(w, value, depth + 1, maxDepth);
+    }
+  } else {
+    w.u8(0xf6); // null
+  }
+}
+
+template <typename Read>
+std::shared_ptr<AnyMap> decodeFrame(const uint8_t* data, size_t size, Read&& read) {
+  Reader r{data, data + size};
+  AnyValue root = read(r);
+  if (r.pos != r.end) {
+    throw std::runtime_error("Trailing bytes after top-level value");
+  }
+  return toAnyMap(std::move(root));
+}
+
+} // namespace
+
+// ============================================================
+// Public API
+// ============================================================
+
+std::shared_ptr<AnyMap> BinaryCodec::decodeMsgPack(const uint8_t* data, size_t size) {
+  return decodeFrame(data, size, [](Reader& r) { return readMsgPack(r, 0, MAX_DEPTH); });
+}
+
+std::vector<uint8_t> BinaryCodec::encodeMsgPack(const std::shared_ptr<AnyMap>& value) {
+  Writer w;
+  const AnyObject empty;
+  writeMsgPackObject(w, value ? value->getMap() : empty, 0, MAX_DEPTH);
+  return std::move(w.out);
+}
+
+std::shared_ptr<AnyMap> BinaryCodec::decodeCbor(const uint8_t* data, size_t size) {
+  return decodeFrame(data, size, [](Reader& r) { return readCbor(r, 0, MAX_DEPTH); });
+}
+
+std::vector<uint8_t> BinaryCodec::encodeCbor(const std::shared_ptr<AnyMap>& value) {
+  Writer w;
+  const AnyObject empty;
+  const AnyObject& object = value ? value->getMap() : empty;
+  writeCborHead(w, 5, object.size());
+  for (const auto& [key, item] : object) {
+    writeCborHead(w, 3, key.size());
+    w.bytes(key.data(), key.size());
+    writeCbor(w, item, 1, MAX_DEPTH);
+  }
+  return std::move(w.out);
+}
+
+} // namespace margelo::nitro::realtimenitro
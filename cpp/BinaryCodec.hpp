@@ -0,0 +1,63 @@
+#pragma once
+
+#include <NitroModules/AnyMap.hpp>
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace margelo::nitro::realtimenitro {
+
+using namespace margelo::nitro;
+
+/**
+ * Native MessagePack / CBOR codecs
+ *
+ * Decodes binary frames straight into Nitro `AnyMap` values on the
+ * I/O thread, so JS receives ready-made objects instead of raw bytes.
+ *
+ * Type mapping (both codecs):
+ * - nil / null / undefined      -> null
+ * - bool                        -> boolean
+ * - int / float                 -> number (bigint if outside +-2^53)
+ * - str                         -> string
+ * - bin / byte string           -> number[] (one entry per byte)
+ * - array                       -> array
+ * - map                         -> object (non-string keys are stringified)
+ * - ext (MessagePack)           -> { type: number, data: number[] }
+ * - tag (CBOR)                  -> tagged value (tag is dropped)
+ *
+ * The top-level value of a frame must be a map/object, because that is
+ * what `AnyMap` can represent.
+ */
+class BinaryCodec {
+public:
+  /**
+   * Decode a MessagePack frame
+   * @throws std::runtime_error if the frame is malformed or not a map
+   */
+  static std::shared_ptr<AnyMap> decodeMsgPack(const uint8_t* data, size_t size);
+
+  /**
+   * Encode an AnyMap as MessagePack
+   */
+  static std::vector<uint8_t> encodeMsgPack(const std::shared_ptr<AnyMap>& value);
+
+  /**
+   * Decode a CBOR (RFC 8949) frame
+   * @throws std::runtime_error if the frame is malformed or not a map
+   */
+  static std::shared_ptr<AnyMap> decodeCbor(const uint8_t* data, size_t size);
+
+  /**
+   * Encode an AnyMap as CBOR
+   */
+  static std::vector<uint8_t> encodeCbor(const std::shared_ptr<AnyMap>& value);
+
+private:
+  // Nesting limit to keep hostile frames from exhausting the stack
+  static constexpr int MAX_DEPTH = 128;
+};
+
+} // namespace margelo::nitro::realtimenitro
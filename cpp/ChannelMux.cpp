@@ -0,0 +1,297 @@
+#include "ChannelMux.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace margelo::nitro::realtimenitro {
+
+namespace {
+
+uint32_t loadU32(const uint8_t* p) {
+  return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+}
+
+// Credit never wraps, whatever the peer grants
+uint32_t addCredit(uint32_t credit, uint32_t bytes) {
+  return static_cast<uint32_t>(std::min<uint64_t>(uint64_t(credit) + bytes, UINT32_MAX));
+}
+
+} // namespace
+
+// ============================================================
+// Framing
+// ============================================================
+
+std::vector<uint8_t> ChannelMux::header(FrameType type, uint16_t id, bool text, size_t payload) {
+  std::vector<uint8_t> bytes;
+  bytes.reserve(HEADER_SIZE + payload);
+  bytes.push_back(MAGIC);
+  bytes.push_back(static_cast<uint8_t>(type | (text ? TEXT_FLAG : 0)));
+  bytes.push_back(static_cast<uint8_t>(id >> 8));
+  bytes.push_back(static_cast<uint8_t>(id & 0xFF));
+  return bytes;
+}
+
+std::vector<uint8_t> ChannelMux::creditFrame(uint16_t id, uint32_t bytes) {
+  auto frame = header(CREDIT, id, false, 4);
+  for (int shift = 24; shift >= 0; shift -= 8) {
+    frame.push_back(static_cast<uint8_t>(bytes >> shift));
+  }
+  return frame;
+}
+
+// ============================================================
+// Channels
+// ============================================================
+
+void ChannelMux::open(uint16_t id, Handler handler, uint32_t window) {
+  if (window < INITIAL_WINDOW || window > MAX_WINDOW) {
+    throw std::invalid_argument("Channel window must be between " + std::to_string(INITIAL_WINDOW) +
+                                " and " + std::to_string(MAX_WINDOW) + " bytes");
+  }
+
+  std::vector<std::vector<uint8_t>> frames;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_channels.count(id)) {
+      throw std::invalid_argument("Channel " + std::to_string(id) + " is already open");
+    }
+    Channel& channel = _channels[id];
+    channel.handler = std::make_shared<Handler>(std::move(handler));
+    channel.window = window;
+
+    // Otherwise announced when the connection opens (see onOpen)
+    auto socket = _socket.lock();
+    if (socket && socket->isOpen() && window > INITIAL_WINDOW) {
+      channel.receiveCredit = window;
+      frames.push_back(creditFrame(id, window - INITIAL_WINDOW));
+    }
+  }
+  sendFrames(frames);
+}
+
+void ChannelMux::close(uint16_t id) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _channels.erase(id);
+}
+
+bool ChannelMux::send(uint16_t id, const uint8_t* data, size_t len, bool isBinary) {
+  // A message must fit the peer's smallest possible window
+  if (len > INITIAL_WINDOW) {
+    return false;
+  }
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _channels.find(id);
+    if (it == _channels.end() || it->second.queuedBytes + len > MAX_QUEUED_BYTES) {
+      return false;
+    }
+    Frame frame{header(DATA, id, !isBinary, len), static_cast<uint32_t>(len)};
+    frame.bytes.insert(frame.bytes.end(), data, data + len);
+    it->second.queuedBytes += len;
+    it->second.queue.push_back(std::move(frame));
+  }
+  pump();
+  return true;
+}
+
+std::optional<ChannelMux::Stats> ChannelMux::stats(uint16_t id) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto it = _channels.find(id);
+  if (it == _channels.end()) {
+    return std::nullopt;
+  }
+  const Channel& channel = it->second;
+  return Stats{
+    channel.messagesSent,
+    channel.messagesReceived,
+    channel.queuedBytes,
+    channel.sendCredit,
+    channel.creditWaits,
+    channel.dropped,
+  };
+}
+
+// ============================================================
+// Send scheduling
+// ============================================================
+
+void ChannelMux::pump() {
+  auto socket = _socket.lock();
+  if (!socket) {
+    return;
+  }
+
+  std::vector<Frame> out;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    // Queues wait for the next connection while closed
+    if (_draining || _channels.empty() || !socket->isOpen()) {
+      return;
+    }
+
+    // Round-robin from the channel after the last one served, one message
+    // per channel per turn, until the budget is spent or nothing can move
+    size_t budget = 0;
+    bool progress = true;
+    while (progress && budget < PUMP_BUDGET) {
+      progress = false;
+      auto it = _channels.upper_bound(_cursor);
+      for (size_t n = 0; n < _channels.size() && budget < PUMP_BUDGET; n++, it++) {
+        if (it == _channels.end()) {
+          it = _channels.begin();
+        }
+        Channel& channel = it->second;
+        if (channel.queue.empty()) {
+          continue;
+        }
+        if (channel.queue.front().payload > channel.sendCredit) {
+          channel.creditWaits++;
+          continue;
+        }
+        Frame frame = std::move(channel.queue.front());
+        channel.queue.pop_front();
+        channel.queuedBytes -= frame.payload;
+        channel.sendCredit -= frame.payload;
+        channel.messagesSent++;
+        budget += frame.bytes.size();
+        out.push_back(std::move(frame));
+        _cursor = it->first;
+        progress = true;
+      }
+    }
+    if (out.empty()) {
+      return;
+    }
+    _draining = true;
+  }
+
+  for (auto& frame : out) {
+    socket->sendNative(frame.bytes.data(), frame.bytes.size(), true);
+  }
+  // Keep the socket queue short so channels queued later still get a
+  // turn soon; the next batch goes out once this one is written
+  socket->whenDrained([weak = weak_from_this()](bool drained) {
+    auto self = weak.lock();
+    if (!self) {
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(self->_mutex);
+      self->_draining = false;
+    }
+    if (drained) {
+      self->pump();
+    }
+  });
+}
+
+void ChannelMux::sendFrames(std::vector<std::vector<uint8_t>>& frames) {
+  auto socket = frames.empty() ? nullptr : _socket.lock();
+  if (!socket) {
+    return;
+  }
+  for (auto& frame : frames) {
+    socket->sendNative(frame.data(), frame.size(), true);
+  }
+}
+
+// ============================================================
+// NativeMessageSink (loop thread)
+// ============================================================
+
+bool ChannelMux::onMessage(const uint8_t* data, size_t len, bool isBinary) {
+  if (!isBinary || len < HEADER_SIZE || data[0] != MAGIC) {
+    return false;
+  }
+  uint8_t type = data[1] & ~TEXT_FLAG;
+  if (type != DATA && type != CREDIT) {
+    return false;
+  }
+  uint16_t id = static_cast<uint16_t>((data[2] << 8) | data[3]);
+  const uint8_t* payload = data + HEADER_SIZE;
+  size_t payloadLen = len - HEADER_SIZE;
+
+  if (type == CREDIT) {
+    if (payloadLen != 4) {
+      return true;
+    }
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      auto it = _channels.find(id);
+      if (it == _channels.end()) {
+        return true;
+      }
+      it->second.sendCredit = addCredit(it->second.sendCredit, loadU32(payload));
+    }
+    pump();
+    return true;
+  }
+
+  std::shared_ptr<Handler> handler;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _channels.find(id);
+    if (it == _channels.end()) {
+      return true;
+    }
+    Channel& channel = it->second;
+    // The peer ignored its credit: drop rather than buffer without bound
+    if (payloadLen > channel.receiveCredit) {
+      channel.dropped++;
+      return true;
+    }
+    channel.receiveCredit -= static_cast<uint32_t>(payloadLen);
+    channel.messagesReceived++;
+    handler = channel.handler;
+  }
+
+  (*handler)(payload, payloadLen, (data[1] & TEXT_FLAG) == 0);
+
+  // Grant consumed bytes back in batches of half a window
+  std::vector<std::vector<uint8_t>> frames;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _channels.find(id);
+    if (it == _channels.end() || it->second.handler != handler) {
+      return true;
+    }
+    Channel& channel = it->second;
+    channel.consumed += static_cast<uint32_t>(payloadLen);
+    if (channel.consumed >= channel.window / 2) {
+      channel.receiveCredit += channel.consumed;
+      frames.push_back(creditFrame(id, channel.consumed));
+      channel.consumed = 0;
+    }
+  }
+  sendFrames(frames);
+  return true;
+}
+
+void ChannelMux::onOpen() {
+  // A new connection starts every channel from the initial window
+  std::vector<std::vector<uint8_t>> frames;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _draining = false;
+    for (auto& [id, channel] : _channels) {
+      channel.sendCredit = INITIAL_WINDOW;
+      channel.receiveCredit = channel.window;
+      channel.consumed = 0;
+      if (channel.window > INITIAL_WINDOW) {
+        frames.push_back(creditFrame(id, channel.window - INITIAL_WINDOW));
+      }
+    }
+  }
+  sendFrames(frames);
+  pump();
+}
+
+void ChannelMux::onClose(int code, const std::string& reason) {
+  // Frames already handed to the socket are gone; queued ones wait for a
+  // reconnect
+  std::lock_guard<std::mutex> lock(_mutex);
+  _draining = false;
+}
+
+} // namespace margelo::nitro::realtimenitro
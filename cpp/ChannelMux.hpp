@@ -0,0 +1,143 @@
+#pragma once
+
+#include "NativeSocket.hpp"
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace margelo::nitro::realtimenitro {
+
+/**
+ * Logical channels multiplexed over one WebSocket
+ *
+ * Each channel frame is one binary WebSocket message with a 4-byte header:
+ *
+ *   byte 0     0xCE (magic)
+ *   byte 1     type: 0 = DATA, 1 = CREDIT; bit 7 set = text payload
+ *   bytes 2-3  channel id (big-endian)
+ *
+ * DATA carries one channel message. CREDIT carries a big-endian uint32:
+ * extra payload bytes the receiver lets the sender put on that channel.
+ *
+ * Flow control is per channel and credit-based, as in HTTP/2. Each side
+ * starts with INITIAL_WINDOW bytes of credit per channel and the receiver
+ * grants consumed bytes back once its handler has run, so a slow channel
+ * stalls only itself. A channel opened with a larger window announces the
+ * difference with a CREDIT frame. The peer must speak the same framing; an
+ * echo server also works, since it reflects our credit grants.
+ *
+ * Sends are queued per channel and written round-robin, one message per
+ * channel per turn, with at most PUMP_BUDGET bytes in the socket's send
+ * queue at a time, so a bulk channel cannot starve the others.
+ *
+ * Frames for channels that are not open are dropped; all other messages
+ * pass through to the socket's usual callbacks.
+ *
+ * Thread Safety:
+ * - All public methods are thread-safe
+ * - Handlers run on the socket's event loop thread, outside the mux lock,
+ *   and may call back into the mux
+ */
+class ChannelMux : public NativeMessageSink, public std::enable_shared_from_this<ChannelMux> {
+public:
+  using Handler = std::function<void(const uint8_t* data, size_t len, bool isBinary)>;
+
+  static constexpr uint8_t MAGIC = 0xCE;
+  static constexpr size_t HEADER_SIZE = 4;
+  static constexpr uint32_t INITIAL_WINDOW = 64 * 1024;
+  static constexpr uint32_t MAX_WINDOW = 16 * 1024 * 1024;
+  static constexpr size_t MAX_QUEUED_BYTES = 8 * 1024 * 1024;  // per channel
+  static constexpr size_t PUMP_BUDGET = 64 * 1024;
+
+  struct Stats {
+    uint64_t messagesSent;
+    uint64_t messagesReceived;
+    size_t queuedBytes;
+    uint32_t sendCredit;
+    uint64_t creditWaits;  // pump turns where the next message lacked credit
+    uint64_t dropped;      // received frames beyond the granted window
+  };
+
+  explicit ChannelMux(std::weak_ptr<NativeSocket> socket) : _socket(std::move(socket)) {}
+
+  /**
+   * Open channel `id`
+   *
+   * @param window Receive window in bytes (INITIAL_WINDOW..MAX_WINDOW)
+   * @throws std::invalid_argument if the channel is open or `window` is out of range
+   */
+  void open(uint16_t id, Handler handler, uint32_t window = INITIAL_WINDOW);
+
+  /**
+   * Close channel `id` and drop its queued sends (no-op if not open)
+   *
+   * Closing is local: the peer keeps its counters, so only reuse an id
+   * once its traffic has drained
+   */
+  void close(uint16_t id);
+
+  /**
+   * Queue a message on channel `id`
+   * @return false if the channel is not open, the message is larger than
+   *         INITIAL_WINDOW, or the channel's queue is full
+   */
+  bool send(uint16_t id, const uint8_t* data, size_t len, bool isBinary);
+
+  /**
+   * Stats for channel `id`, or nullopt if it is not open
+   */
+  std::optional<Stats> stats(uint16_t id);
+
+  bool onMessage(const uint8_t* data, size_t len, bool isBinary) override;
+  void onOpen() override;
+  void onClose(int code, const std::string& reason) override;
+
+private:
+  enum FrameType : uint8_t {
+    DATA = 0,
+    CREDIT = 1,
+  };
+  static constexpr uint8_t TEXT_FLAG = 0x80;
+
+  struct Frame {
+    std::vector<uint8_t> bytes;  // header + payload
+    uint32_t payload;
+  };
+
+  struct Channel {
+    std::shared_ptr<Handler> handler;  // copied out to run unlocked
+    uint32_t window;
+    uint32_t sendCredit = INITIAL_WINDOW;
+    uint32_t receiveCredit = INITIAL_WINDOW;  // peer's remaining allowance
+    uint32_t consumed = 0;  // delivered, not yet granted back
+    std::deque<Frame> queue;
+    size_t queuedBytes = 0;
+    uint64_t messagesSent = 0;
+    uint64_t messagesReceived = 0;
+    uint64_t creditWaits = 0;
+    uint64_t dropped = 0;
+  };
+
+  static std::vector<uint8_t> header(FrameType type, uint16_t id, bool text, size_t payload);
+  static std::vector<uint8_t> creditFrame(uint16_t id, uint32_t bytes);
+
+  // Move fairly scheduled frames into the socket queue
+  void pump();
+  // Send CREDIT frames straight to the socket (bypassing the channel queues)
+  void sendFrames(std::vector<std::vector<uint8_t>>& frames);
+
+  std::weak_ptr<NativeSocket> _socket;
+  std::mutex _mutex;
+  std::map<uint16_t, Channel> _channels;
+  uint16_t _cursor = 0;     // last channel served by pump()
+  bool _draining = false;   // frames in the socket queue, pump() waits for the drain
+};
+
+} // namespace margelo::nitro::realtimenitro
@@ -0,0 +1,144 @@
+#include "DnsResolver.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iterator>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+namespace margelo::nitro::realtimenitro {
+
+namespace {
+
+struct Entry {
+  DnsResolver::Addresses addresses;
+  std::chrono::steady_clock::time_point expires;
+};
+
+// Process-wide; the loops all share one cache
+std::mutex dnsMutex;
+std::unordered_map<std::string, Entry> dnsCache;
+// Callbacks waiting on a lookup already in flight
+std::unordered_map<std::string, std::vector<DnsResolver::Callback>> dnsInFlight;
+
+DnsResolver::Addresses lookup(const std::string& host) {
+  struct addrinfo hints = {};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_flags = AI_ADDRCONFIG;
+  struct addrinfo* result = nullptr;
+  int rc = getaddrinfo(host.c_str(), nullptr, &hints, &result);
+  if (rc != 0) {
+    #ifdef DEBUG
+    printf("[WebSocket] DNS lookup for %s failed: %s\n", host.c_str(), gai_strerror(rc));
+    #endif
+    return {};
+  }
+
+  DnsResolver::Addresses addresses;
+  char buffer[INET6_ADDRSTRLEN];
+  for (auto* ai = result; ai; ai = ai->ai_next) {
+    const char* address = nullptr;
+    if (ai->ai_family == AF_INET6) {
+      address = inet_ntop(AF_INET6, &reinterpret_cast<const sockaddr_in6*>(ai->ai_addr)->sin6_addr,
+                          buffer, sizeof(buffer));
+    } else if (ai->ai_family == AF_INET) {
+      address = inet_ntop(AF_INET, &reinterpret_cast<const sockaddr_in*>(ai->ai_addr)->sin_addr,
+                          buffer, sizeof(buffer));
+    }
+    if (address && std::find(addresses.begin(), addresses.end(), address) == addresses.end()) {
+      addresses.emplace_back(address);
+    }
+  }
+  freeaddrinfo(result);
+  return addresses;
+}
+
+// dnsMutex must be held
+void store(const std::string& host, const DnsResolver::Addresses& addresses) {
+  auto now = std::chrono::steady_clock::now();
+  if (dnsCache.size() >= DnsResolver::MAX_ENTRIES) {
+    for (auto it = dnsCache.begin(); it != dnsCache.end();) {
+      it = it->second.expires <= now ? dnsCache.erase(it) : std::next(it);
+    }
+    if (dnsCache.size() >= DnsResolver::MAX_ENTRIES) {
+      dnsCache.erase(dnsCache.begin());
+    }
+  }
+  dnsCache[host] = Entry{addresses, now + std::chrono::milliseconds(DnsResolver::TTL_MS)};
+}
+
+void finish(const std::string& host, const DnsResolver::Addresses& addresses) {
+  std::vector<DnsResolver::Callback> waiters;
+  {
+    std::lock_guard<std::mutex> lock(dnsMutex);
+    if (!addresses.empty()) {
+      store(host, addresses);
+    }
+    auto it = dnsInFlight.find(host);
+    if (it != dnsInFlight.end()) {
+      waiters = std::move(it->second);
+      dnsInFlight.erase(it);
+    }
+  }
+  for (auto& waiter : waiters) {
+    waiter(addresses);
+  }
+}
+
+} // namespace
+
+std::optional<DnsResolver::Addresses> DnsResolver::cached(const std::string& host) {
+  std::lock_guard<std::mutex> lock(dnsMutex);
+  auto it = dnsCache.find(host);
+  if (it == dnsCache.end() || it->second.expires <= std::chrono::steady_clock::now()) {
+    return std::nullopt;
+  }
+  return it->second.addresses;
+}
+
+void DnsResolver::resolve(const std::string& host, Callback callback) {
+  {
+    std::unique_lock<std::mutex> lock(dnsMutex);
+    auto it = dnsCache.find(host);
+    if (it != dnsCache.end() && it->second.expires > std::chrono::steady_clock::now()) {
+      Addresses addresses = it->second.addresses;
+      lock.unlock();
+      callback(addresses);
+      return;
+    }
+    auto& waiters = dnsInFlight[host];
+    waiters.push_back(std::move(callback));
+    // Joined a lookup that is already running
+    if (waiters.size() > 1) {
+      return;
+    }
+  }
+
+  // getaddrinfo() blocks for as long as the network takes, so it never
+  // runs on a loop
+  try {
+    std::thread([host]() {
+      finish(host, lookup(host));
+    }).detach();
+  } catch (const std::system_error& e) {
+    printf("[WebSocket] Failed to start DNS lookup for %s: %s\n", host.c_str(), e.what());
+    finish(host, {});
+  }
+}
+
+bool DnsResolver::isLiteral(const std::string& host) {
+  unsigned char literal[sizeof(struct in6_addr)];
+  return inet_pton(AF_INET, host.c_str(), literal) == 1 ||
+         inet_pton(AF_INET6, host.c_str(), literal) == 1;
+}
+
+} // namespace margelo::nitro::realtimenitro
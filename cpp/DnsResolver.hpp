@@ -0,0 +1,58 @@
+#pragma once
+
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace margelo::nitro::realtimenitro {
+
+/**
+ * Host name resolution through the system resolver, off the event loops
+ *
+ * Lookups go through getaddrinfo(), so they follow the platform's DNS
+ * configuration: VPN and Private DNS, split-horizon setups and the hosts
+ * file. Each distinct host is looked up on its own short-lived thread, so
+ * a slow name never holds up a loop or another lookup, and concurrent
+ * requests for the same host share one query.
+ *
+ * Answers are cached per host for TTL_MS. getaddrinfo() does not report
+ * record TTLs, so this is a fixed, short lifetime; failures are not cached.
+ *
+ * Thread Safety:
+ * - All methods are thread-safe
+ * - Callbacks run on the resolver thread, or inline for cached answers
+ */
+class DnsResolver {
+public:
+  static constexpr int TTL_MS = 60000;
+  static constexpr size_t MAX_ENTRIES = 256;
+
+  // IP literals in the system's preference order (RFC 6724); empty on failure
+  using Addresses = std::vector<std::string>;
+  using Callback = std::function<void(const Addresses& addresses)>;
+
+  /**
+   * Cached answer for `host`, or nullopt if it is unknown or expired
+   */
+  static std::optional<Addresses> cached(const std::string& host);
+
+  /**
+   * Resolve `host`, answering from the cache when possible
+   */
+  static void resolve(const std::string& host, Callback callback);
+
+  /**
+   * True if `host` is an IPv4 or IPv6 literal (nothing to resolve)
+   */
+  static bool isLiteral(const std::string& host);
+
+  /**
+   * True if `address` is an IPv6 literal
+   */
+  static bool isIpv6(const std::string& address) {
+    return address.find(':') != std::string::npos;
+  }
+};
+
+} // namespace margelo::nitro::realtimenitro
@@ -0,0 +1,411 @@
+#include "EventLoop.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <future>
+#include <stdexcept>
+
+#include <pthread.h>
+#if defined(__APPLE__)
+#include <pthread/qos.h>
+#else
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace margelo::nitro::realtimenitro {
+
+namespace {
+
+// Per-message-deflate compression extension (shared by all client vhosts)
+// This can reduce bandwidth by 60-80% for text messages
+const struct lws_extension extensions[] = {
+  {
+    "permessage-deflate",
+    lws_extension_callback_pm_deflate,
+    "permessage-deflate"
+    "; client_no_context_takeover"
+    "; client_max_window_bits"
+  },
+  { nullptr, nullptr, nullptr }
+};
+
+// Client TLS session cache per vhost, keyed by host:port. Reconnects offer
+// the cached ticket/ID and skip the full handshake when the server accepts it
+constexpr uint32_t TLS_SESSION_CACHE_MAX = 32;
+constexpr uint32_t TLS_SESSION_TIMEOUT_SECS = 3600;
+
+// Control vhost protocol: receives EVENT_WAIT_CANCELLED to run posted tasks
+struct lws_protocols loopProtocols[2] = {};
+
+// Loop pool. Loops are created together on first acquire() and are
+// intentionally leaked: their threads must outlive every instance,
+// including ones destroyed during static destruction
+struct Pool {
+  size_t size = 1;
+  EventLoop::Assignment assignment = EventLoop::Assignment::LEAST_LOAD;
+  EventLoop::ThreadOptions threadOptions;
+  std::vector<EventLoop*> loops;
+};
+
+// Only taken to pick a loop or reconfigure, never on the I/O path
+std::mutex poolMutex;
+Pool pool;
+
+// Thread name for loop `index`: "name" for a single loop, "name-3" in a pool
+std::string threadName(const std::string& base, size_t index, size_t count) {
+  if (count <= 1) {
+    return base;
+  }
+  std::string suffix = "-" + std::to_string(index);
+#if defined(__APPLE__)
+  return base + suffix;
+#else
+  // Linux limits thread names to 15 characters; keep the index visible
+  return base.substr(0, 15 - suffix.size()) + suffix;
+#endif
+}
+
+// Apply scheduling options to the calling thread; failures are logged, not fatal
+void applyThreadOptions(const EventLoop::ThreadOptions& options, const std::string& name) {
+#if defined(__APPLE__)
+  pthread_setname_np(name.c_str());
+
+  if (options.nice.has_value()) {
+    // Darwin schedules by QoS class rather than nice value
+    int nice = options.nice.value();
+    qos_class_t qos = nice <= -10 ? QOS_CLASS_USER_INTERACTIVE :
+                      nice < 0 ? QOS_CLASS_USER_INITIATED :
+                      nice == 0 ? QOS_CLASS_DEFAULT :
+                      nice < 10 ? QOS_CLASS_UTILITY :
+                      QOS_CLASS_BACKGROUND;
+    if (pthread_set_qos_class_self_np(qos, 0) != 0) {
+      printf("[WebSocket] Failed to set event loop QoS class\n");
+    }
+  }
+  // No thread affinity API on Apple platforms: cpus are ignored
+#else
+  // Linux limits thread names to 15 characters
+  pthread_setname_np(pthread_self(), name.substr(0, 15).c_str());
+
+  if (options.nice.has_value()) {
+    // With a thread id, setpriority() only affects this thread
+    auto tid = static_cast<id_t>(syscall(SYS_gettid));
+    if (setpriority(PRIO_PROCESS, tid, options.nice.value()) != 0) {
+      printf("[WebSocket] Failed to set event loop nice to %d: %s\n",
+             options.nice.value(), strerror(errno));
+    }
+  }
+
+  if (!options.cpus.empty()) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : options.cpus) {
+      // CPU_SET does no bounds check of its own
+      if (cpu >= 0 && cpu < CPU_SETSIZE) {
+        CPU_SET(cpu, &set);
+      }
+    }
+    if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+      printf("[WebSocket] Failed to set event loop CPU affinity: %s\n", strerror(errno));
+    }
+  }
+#endif
+}
+
+} // namespace
+
+// ============================================================
+// Lifecycle
+// ============================================================
+
+EventLoop::Assignment EventLoop::parseAssignment(const std::string& name) {
+  if (name == "least-load") {
+    return Assignment::LEAST_LOAD;
+  }
+  if (name == "hash") {
+    return Assignment::HASH;
+  }
+  throw std::invalid_argument("Unknown loop assignment '" + name + "' (expected 'least-load' or 'hash')");
+}
+
+void EventLoop::configurePool(size_t count, Assignment assignment) {
+  if (count < 1 || count > MAX_LOOPS) {
+    throw std::invalid_argument("Event loop count must be between 1 and " + std::to_string(MAX_LOOPS));
+  }
+
+  std::lock_guard<std::mutex> lock(poolMutex);
+  if (!pool.loops.empty() && count != pool.size) {
+    throw std::runtime_error("Event loop count must be configured before the first connect()");
+  }
+  pool.size = count;
+  pool.assignment = assignment;
+}
+
+void EventLoop::startPoolLocked() {
+  if (pool.loops.empty()) {
+    for (size_t i = 0; i < pool.size; i++) {
+      pool.loops.push_back(new EventLoop(i, pool.threadOptions));
+    }
+  }
+}
+
+EventLoop* EventLoop::acquire(const std::string& key) {
+  std::lock_guard<std::mutex> lock(poolMutex);
+  startPoolLocked();
+
+  if (pool.assignment == Assignment::HASH) {
+    return pool.loops[std::hash<std::string>{}(key) % pool.loops.size()];
+  }
+
+  EventLoop* best = pool.loops.front();
+  for (auto* loop : pool.loops) {
+    if (loop->connectionCount() < best->connectionCount()) {
+      best = loop;
+    }
+  }
+  return best;
+}
+
+size_t EventLoop::poolSize() {
+  std::lock_guard<std::mutex> lock(poolMutex);
+  return pool.size;
+}
+
+EventLoop::EventLoop(size_t index, const ThreadOptions& options) : _index(index) {
+  loopProtocols[0] = {
+    .name = "realtime-nitro-loop",
+    .callback = EventLoop::loopCallback,
+    .per_session_data_size = 0,
+    .rx_buffer_size = 0,
+    .id = 0,
+    .user = nullptr,
+    .tx_packet_size = 0,
+  };
+  loopProtocols[1] = {}; // LWS_PROTOCOL_LIST_TERM
+
+  // Enable LibWebSockets logging for debugging
+  // Note: On iOS/Android, these logs may go to system logs (use adb logcat or Xcode console)
+  lws_set_log_level(LLL_ERR | LLL_WARN | LLL_NOTICE | LLL_USER, nullptr);
+
+  struct lws_context_creation_info info;
+  std::memset(&info, 0, sizeof(info));
+
+  info.port = CONTEXT_PORT_NO_LISTEN;
+  info.gid = -1;
+  info.uid = -1;
+  info.user = this;
+  // lws ref-counts the global SSL init across the pool's contexts;
+  // client vhosts are added on demand
+  info.options = LWS_SERVER_OPTION_DO_SSL_GLOBAL_INIT | LWS_SERVER_OPTION_EXPLICIT_VHOSTS;
+
+  printf("[WebSocket] Creating LibWebSockets context for event loop %zu...\n", index);
+  _context = lws_create_context(&info);
+  if (!_context) {
+    printf("[WebSocket] ❌ FAILED to create context!\n");
+    throw std::runtime_error("Failed to create WebSocket context - check LibWebSockets installation");
+  }
+
+  info.protocols = loopProtocols;
+  info.vhost_name = "realtime-nitro-loop";
+  if (!lws_create_vhost(_context, &info)) {
+    lws_context_destroy(_context);
+    throw std::runtime_error("Failed to create WebSocket event loop");
+  }
+
+  _running = true;
+  _thread = std::thread([this, options, name = threadName(options.name, index, pool.size)]() {
+    applyThreadOptions(options, name);
+    run();
+  });
+}
+
+EventLoop::~EventLoop() {
+  _running = false;
+  lws_cancel_service(_context);
+  if (_thread.joinable()) {
+    _thread.join();
+  }
+  lws_context_destroy(_context);
+}
+
+void EventLoop::setThreadOptions(const ThreadOptions& options) {
+  // Holding the pool lock means options reach every loop exactly once:
+  // either at thread start or through a posted task
+  std::lock_guard<std::mutex> lock(poolMutex);
+  pool.threadOptions = options;
+  for (auto* loop : pool.loops) {
+    loop->post([options, name = threadName(options.name, loop->_index, pool.loops.size())]() {
+      applyThreadOptions(options, name);
+    });
+  }
+}
+
+// ============================================================
+// Service thread
+// ============================================================
+
+void EventLoop::run() {
+  while (_running) {
+    // Blocks until socket activity, the next scheduled lws timer or
+    // lws_cancel_service(); lws 4.x derives the wait from its timer list
+    // and ignores the timeout argument
+    if (lws_service(_context, 0) < 0) {
+      break;
+    }
+    _servicePasses.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void EventLoop::runPendingTasks() {
+  // Clear before draining: a post() racing with the swap below either lands
+  // in this batch or triggers a fresh wakeup, never neither
+  _wakePending.store(false, std::memory_order_release);
+
+  std::vector<std::function<void()>> tasks;
+  {
+    std::lock_guard<std::mutex> lock(_taskMutex);
+    tasks.swap(_tasks);
+  }
+
+  for (auto& task : tasks) {
+    task();
+  }
+  _tasksRun.fetch_add(tasks.size(), std::memory_order_relaxed);
+}
+
+int EventLoop::loopCallback(
+    struct lws* wsi,
+    enum lws_callback_reasons reason,
+    void* user,
+    void* in,
+    size_t len) {
+  if (reason == LWS_CALLBACK_EVENT_WAIT_CANCELLED && wsi) {
+    auto* loop = static_cast<EventLoop*>(lws_context_user(lws_get_context(wsi)));
+    if (loop) {
+      loop->runPendingTasks();
+    }
+  }
+  return 0;
+}
+
+// ============================================================
+// Cross-thread tasks
+// ============================================================
+
+void EventLoop::post(std::function<void()> task) {
+  {
+    std::lock_guard<std::mutex> lock(_taskMutex);
+    _tasks.push_back(std::move(task));
+  }
+
+  // Only the first post() since the last drain needs to interrupt poll()
+  if (!_wakePending.exchange(true, std::memory_order_acq_rel)) {
+    _wakeups.fetch_add(1, std::memory_order_relaxed);
+    lws_cancel_service(_context);
+  }
+}
+
+void EventLoop::runSync(const std::function<void()>& task) {
+  if (isLoopThread()) {
+    task();
+    return;
+  }
+
+  std::promise<void> done;
+  auto result = done.get_future();
+  post([&task, &done]() {
+    try {
+      task();
+      done.set_value();
+    } catch (...) {
+      done.set_exception(std::current_exception());
+    }
+  });
+  result.get();
+}
+
+EventLoop::Stats EventLoop::stats() const {
+  return Stats{
+    _servicePasses.load(std::memory_order_relaxed),
+    _wakeups.load(std::memory_order_relaxed),
+    _tasksRun.load(std::memory_order_relaxed),
+  };
+}
+
+EventLoop::Stats EventLoop::totalStats() {
+  std::lock_guard<std::mutex> lock(poolMutex);
+  Stats total{};
+  for (auto* loop : pool.loops) {
+    Stats stats = loop->stats();
+    total.servicePasses += stats.servicePasses;
+    total.wakeups += stats.wakeups;
+    total.tasks += stats.tasks;
+  }
+  return total;
+}
+
+bool EventLoop::isLoopThread() const {
+  return std::this_thread::get_id() == _thread.get_id();
+}
+
+// ============================================================
+// Vhosts
+// ============================================================
+
+struct lws_vhost* EventLoop::vhostFor(const VhostConfig& config, lws_callback_function callback, bool& reused) {
+  auto it = _vhosts.find(config);
+  reused = it != _vhosts.end();
+  if (reused) {
+    return it->second->vhost;
+  }
+
+  auto entry = std::make_unique<Vhost>();
+  entry->protocols[0] = {
+    .name = CLIENT_PROTOCOL,
+    .callback = callback,
+    .per_session_data_size = 0,
+    .rx_buffer_size = config.rxBufferSize,
+    .id = 0,
+    .user = nullptr,
+    .tx_packet_size = 0, // 0 = use default
+  };
+  entry->protocols[1] = {}; // LWS_PROTOCOL_LIST_TERM
+  entry->name = "client-" + std::to_string(_vhosts.size());
+
+  struct lws_context_creation_info info;
+  std::memset(&info, 0, sizeof(info));
+
+  info.port = CONTEXT_PORT_NO_LISTEN;
+  info.gid = -1;
+  info.uid = -1;
+  info.protocols = entry->protocols;
+  info.extensions = extensions;
+  info.vhost_name = entry->name.c_str();
+  // The CA store is parsed once here and shared by every connection on this vhost
+  info.client_ssl_ca_filepath = config.caPath.empty() ? nullptr : config.caPath.c_str();
+#if defined(LWS_WITH_TLS_SESSIONS)
+  // Servers still cap the lifetime with their own ticket / session timeout
+  info.tls_session_cache_max = TLS_SESSION_CACHE_MAX;
+  info.tls_session_timeout = TLS_SESSION_TIMEOUT_SECS;
+#endif
+
+  printf("[WebSocket] Creating client vhost %s (CA: %s, rx buffer: %zu)\n",
+         entry->name.c_str(),
+         config.caPath.empty() ? "none" : config.caPath.c_str(),
+         config.rxBufferSize);
+
+  entry->vhost = lws_create_vhost(_context, &info);
+  if (!entry->vhost) {
+    printf("[WebSocket] ❌ FAILED to create client vhost!\n");
+    return nullptr;
+  }
+
+  auto* vhost = entry->vhost;
+  _vhosts.emplace(config, std::move(entry));
+  return vhost;
+}
+
+} // namespace margelo::nitro::realtimenitro
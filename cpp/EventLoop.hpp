@@ -0,0 +1,203 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include <libwebsockets.h>
+
+#if !defined(__APPLE__)
+#include <sched.h>
+#endif
+
+namespace margelo::nitro::realtimenitro {
+
+/**
+ * libwebsockets event loop shared by WebSocket instances
+ *
+ * The process runs a pool of N loops (1 by default). Each loop owns one
+ * lws_context and one service thread, and each connection lives on exactly
+ * one loop, so loops never share locks or lws state. Connections are created,
+ * written and torn down on that thread; other threads talk to it through
+ * `post()` / `runSync()`, which wake the loop via `lws_cancel_service()`
+ * (the only thread-safe lws call).
+ *
+ * The loop is purely event-driven: it sleeps in poll() until socket
+ * readiness, the next lws timer (pings, timeouts) or an explicit wakeup.
+ * There is no polling interval, so idle sockets cost no CPU and queued
+ * sends add no latency.
+ *
+ * Client vhosts are cached by configuration (CA path, receive buffer size)
+ * so TLS init and CA parsing happen once per distinct configuration rather
+ * than once per connection. Host names never reach lws: connections dial
+ * IP literals resolved off the loop (see DnsResolver). Each vhost also
+ * caches client TLS sessions per host:port, so reconnects to the same
+ * server resume instead of running a full handshake.
+ *
+ * Thread Safety:
+ * - `post()`, `runSync()`, `isLoopThread()` and the static pool functions
+ *   are thread-safe
+ * - `vhostFor()`, `connectionOpened()` and `connectionClosed()` must be
+ *   called on the loop thread
+ */
+class EventLoop {
+public:
+  // Protocol name for client connections (also sent as the subprotocol)
+  static constexpr const char* CLIENT_PROTOCOL = "websocket-protocol";
+
+  struct VhostConfig {
+    std::string caPath;    // empty = no CA store
+    size_t rxBufferSize;   // bytes read per receive callback
+
+    bool operator<(const VhostConfig& other) const {
+      return std::tie(caPath, rxBufferSize) < std::tie(other.caPath, other.rxBufferSize);
+    }
+  };
+
+  struct ThreadOptions {
+    std::string name = "rtn-event-loop";
+    std::optional<int> nice;   // -20..19, nullopt = leave unchanged
+    std::vector<int> cpus;     // 0..MAX_CPUS-1, empty = leave unchanged
+  };
+
+  // Size of cpu_set_t (32 on 32-bit Android); Apple has no affinity API
+#if defined(CPU_SETSIZE)
+  static constexpr int MAX_CPUS = CPU_SETSIZE;
+#else
+  static constexpr int MAX_CPUS = 1024;
+#endif
+
+  enum class Assignment {
+    LEAST_LOAD,  // loop with the fewest open connections
+    HASH         // stable loop per key (e.g. URL)
+  };
+
+  static constexpr size_t MAX_LOOPS = 64;
+
+  /**
+   * Parse an assignment name ("least-load" or "hash")
+   * @throws std::invalid_argument for unknown names
+   */
+  static Assignment parseAssignment(const std::string& name);
+
+  /**
+   * Set the pool size and assignment policy
+   * @throws std::runtime_error once the pool has started
+   */
+  static void configurePool(size_t count, Assignment assignment);
+
+  /**
+   * Set scheduling options for all loop threads
+   * Applied immediately to running loops, otherwise when they start
+   */
+  static void setThreadOptions(const ThreadOptions& options);
+
+  /**
+   * Pick a loop for a new connection (starts the pool on first use;
+   * loops are never destroyed)
+   *
+   * @param key Hash key for Assignment::HASH
+   * @throws std::runtime_error if an lws context cannot be created
+   */
+  static EventLoop* acquire(const std::string& key);
+
+  EventLoop(const EventLoop&) = delete;
+  EventLoop& operator=(const EventLoop&) = delete;
+
+  /**
+   * Queue a task to run on the loop thread and wake the loop
+   */
+  void post(std::function<void()> task);
+
+  /**
+   * Run a task on the loop thread and wait for it to finish
+   * Runs inline when called from the loop thread; rethrows task exceptions
+   */
+  void runSync(const std::function<void()>& task);
+
+  bool isLoopThread() const;
+
+  struct lws_context* context() const { return _context; }
+
+  struct Stats {
+    uint64_t servicePasses;
+    uint64_t wakeups;
+    uint64_t tasks;
+  };
+
+  Stats stats() const;
+
+  /**
+   * Stats summed over all running loops
+   */
+  static Stats totalStats();
+
+  static size_t poolSize();
+
+  // Connection accounting for least-load assignment
+  void connectionOpened() { _connections.fetch_add(1, std::memory_order_relaxed); }
+  void connectionClosed() { _connections.fetch_sub(1, std::memory_order_relaxed); }
+  size_t connectionCount() const { return _connections.load(std::memory_order_relaxed); }
+
+  /**
+   * Client vhost for `config`, created on first use (loop thread only)
+   *
+   * @param callback Protocol callback for connections on this vhost
+   * @param reused Set to true if an existing vhost (and its TLS state) was returned
+   * @return nullptr if the vhost could not be created
+   */
+  struct lws_vhost* vhostFor(const VhostConfig& config, lws_callback_function callback, bool& reused);
+
+private:
+  EventLoop(size_t index, const ThreadOptions& options);
+  ~EventLoop();
+
+  struct Vhost {
+    // lws keeps a pointer to the protocol table, so it lives with the vhost
+    struct lws_protocols protocols[2] = {};
+    std::string name;
+    struct lws_vhost* vhost = nullptr;
+  };
+
+  size_t _index;
+  struct lws_context* _context = nullptr;
+  std::thread _thread;
+  std::atomic<size_t> _connections{0};
+  std::atomic<bool> _running{false};
+
+  std::vector<std::function<void()>> _tasks;
+  std::mutex _taskMutex;
+  // Set between a wakeup and the loop draining tasks, so bursts of
+  // post() calls from other threads cost one lws_cancel_service()
+  std::atomic<bool> _wakePending{false};
+
+  std::atomic<uint64_t> _servicePasses{0};
+  std::atomic<uint64_t> _wakeups{0};
+  std::atomic<uint64_t> _tasksRun{0};
+
+  // Loop thread only
+  std::map<VhostConfig, std::unique_ptr<Vhost>> _vhosts;
+
+  void run();
+  void runPendingTasks();
+
+  // Create the loops on first use; poolMutex must be held
+  static void startPoolLocked();
+
+  static int loopCallback(
+    struct lws* wsi,
+    enum lws_callback_reasons reason,
+    void* user,
+    void* in,
+    size_t len
+  );
+};
+
+} // namespace margelo::nitro::realtimenitro
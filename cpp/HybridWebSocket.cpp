@@ -1,10 +1,22 @@
 #include "HybridWebSocket.hpp"
+#include "BinaryCodec.hpp"
 #include <NitroModules/ArrayBuffer.hpp>
 
 #include <sstream>
+#include <deque>
 #include <chrono>
 #include <cstring>
 #include <algorithm>
+#include <cmath>
+#include <random>
+#include <cerrno>
+#include <climits>
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
 
 // LibWebSockets includes
 #include <libwebsockets.h>
@@ -16,34 +28,48 @@ extern "C" const char* getRealTimeNitroCACertPath();
 
 namespace margelo::nitro::realtimenitro {
 
-// ============================================================
-// User data stored per WebSocket connection
-// ============================================================
-
-struct WebSocketUserData {
-  HybridWebSocket* instance;
-};
-
 // ============================================================
 // Constructor / Destructor
 // ============================================================
 
 HybridWebSocket::~HybridWebSocket() {
-  cleanup();
+  if (!_nativeName.empty()) {
+    NativeSocketRegistry::remove(_nativeName, this);
+  }
+
+  // Never waits for the loop. Nothing on the loop can be using this
+  // instance (tasks hold a strong reference, callbacks lock a weak one),
+  // so hand the link over and let the loop detach and release it.
+  // Callbacks that arrive first find the owner gone and are ignored
+  if (_loop) {
+    _loop->post([link = std::move(_link), promise = std::move(_connectPromise)]() {
+      if (link) {
+        detach(*link);
+      }
+      if (promise) {
+        promise->reject(std::make_exception_ptr(std::runtime_error("Connection aborted")));
+      }
+    });
+  }
+  failDrainWaiters();
+}
+
+std::shared_ptr<HybridWebSocket> HybridWebSocket::shared() {
+  return std::dynamic_pointer_cast<HybridWebSocket>(shared_from_this());
 }
 
 // ============================================================
 // URL Parsing
 // ============================================================
 
-bool HybridWebSocket::parseUrl(const std::string& url) {
+bool HybridWebSocket::parseEndpoint(const std::string& url, Endpoint& endpoint) {
   size_t pos = 0;
   // 1. Check protocol
   if (url.find("wss://") == 0) {
-    _useSsl = true;
+    endpoint.useSsl = true;
     pos = 6;
   } else if (url.find("ws://") == 0) {
-    _useSsl = false;
+    endpoint.useSsl = false;
     pos = 5;
   } else {
     return false;
@@ -55,13 +81,13 @@ bool HybridWebSocket::parseUrl(const std::string& url) {
     hostEnd = url.length();
   }
   
-  _host = url.substr(pos, hostEnd - pos);
-  if (_host.empty()) {
+  endpoint.host = url.substr(pos, hostEnd - pos);
+  if (endpoint.host.empty()) {
     return false;
   }
   
   // 3. Parse port (if present)
-  _port = _useSsl ? 443 : 80;
+  endpoint.port = endpoint.useSsl ? 443 : 80;
   
   if (hostEnd < url.length() && url[hostEnd] == ':') {
     size_t portStart = hostEnd + 1;
@@ -72,7 +98,7 @@ bool HybridWebSocket::parseUrl(const std::string& url) {
     
     std::string portStr = url.substr(portStart, portEnd - portStart);
     try {
-      _port = std::stoi(portStr);
+      endpoint.port = std::stoi(portStr);
     } catch (...) {
       return false;
     }
@@ -82,12 +108,12 @@ bool HybridWebSocket::parseUrl(const std::string& url) {
   
   // 4. Parse path
   if (hostEnd < url.length() && url[hostEnd] == '/') {
-    _path = url.substr(hostEnd);
+    endpoint.path = url.substr(hostEnd);
   } else {
-    _path = "/";
+    endpoint.path = "/";
   }
   
-  _url = url;
+  endpoint.url = url;
   return true;
 }
 
@@ -97,514 +123,2576 @@ bool HybridWebSocket::parseUrl(const std::string& url) {
 
 std::shared_ptr<Promise<void>> HybridWebSocket::connect(
     const std::string& url,
-    const std::optional<std::vector<std::string>>& protocols) {
+    const std::optional<std::vector<std::string>>& protocols,
+    const std::optional<WebSocketOptions>& options) {
   
-  return Promise<void>::async([this, url, protocols]() {
-    // Validate and parse URL
-    if (!parseUrl(url)) {
-      throw std::invalid_argument("Invalid WebSocket URL: " + url);
-    }
+  // Parsed into locals: the loop thread owns the connection fields and
+  // they are published by the task below, once everything validated.
+  // `url` is always the first endpoint; duplicates are dropped
+  std::vector<Endpoint> endpoints(1);
+  if (!parseEndpoint(url, endpoints.front())) {
+    return Promise<void>::rejected(
+      std::make_exception_ptr(std::invalid_argument("Invalid WebSocket URL: " + url)));
+  }
+  const Endpoint target = endpoints.front();
+
+  // Validate options before touching the current connection
+  std::optional<double> timeoutMs = options.has_value() ? options->timeout : std::nullopt;
+  bool happyEyeballs = !options.has_value() || options->happyEyeballs.value_or(true);
+  if (timeoutMs.has_value() && !(timeoutMs.value() > 0)) {
+    return Promise<void>::rejected(
+      std::make_exception_ptr(std::invalid_argument("Connect timeout must be a positive number of milliseconds")));
+  }
 
-    // Cleanup any existing connection
-    cleanup();
+  std::string endpointKey = url;
+  if (options.has_value() && options->endpoints.has_value()) {
+    for (const auto& endpointUrl : options->endpoints.value()) {
+      Endpoint endpoint;
+      if (!parseEndpoint(endpointUrl, endpoint)) {
+        return Promise<void>::rejected(
+          std::make_exception_ptr(std::invalid_argument("Invalid WebSocket URL: " + endpointUrl)));
+      }
+      if (std::none_of(endpoints.begin(), endpoints.end(),
+                       [&](const Endpoint& other) { return other.url == endpoint.url; })) {
+        endpointKey += ' ' + endpoint.url;
+        endpoints.push_back(std::move(endpoint));
+      }
+    }
+  }
+  EndpointStrategy endpointStrategy = EndpointStrategy::PRIORITY;
+  int failoverDelayMs = DEFAULT_FAILOVER_DELAY_MS;
+  SocketTuning socketTuning;
+  try {
+    if (options.has_value() && options->endpointStrategy.has_value()) {
+      endpointStrategy = parseEndpointStrategy(options->endpointStrategy.value());
+    }
+    socketTuning = parseSocketOptions(options.has_value() ? options->socket : std::nullopt);
+  } catch (...) {
+    return Promise<void>::rejected(std::current_exception());
+  }
+  if (options.has_value() && options->failoverDelay.has_value()) {
+    if (!(options->failoverDelay.value() > 0)) {
+      return Promise<void>::rejected(
+        std::make_exception_ptr(std::invalid_argument("Failover delay must be a positive number of milliseconds")));
+    }
+    failoverDelayMs = static_cast<int>(std::min(options->failoverDelay.value(), 60000.0));
+  }
 
-    _state = State::CONNECTING;
+  std::vector<std::pair<std::string, std::string>> headers;
+  if (options.has_value() && options->headers.has_value()) {
+    for (const auto& [name, value] : options->headers.value()) {
+      if (name.empty() ||
+          name.find_first_of(":\r\n") != std::string::npos ||
+          value.find_first_of("\r\n") != std::string::npos) {
+        return Promise<void>::rejected(
+          std::make_exception_ptr(std::invalid_argument("Invalid handshake header: " + name)));
+      }
+      headers.emplace_back(name, value);
+    }
+  }
 
-    // Setup LibWebSockets protocols list with compression support
-    static struct lws_protocols protocolsList[] = {
-      {
-        .name = "websocket-protocol",
-        .callback = HybridWebSocket::websocketCallback,
-        .per_session_data_size = sizeof(WebSocketUserData),
-        .rx_buffer_size = 65536,
-        .tx_packet_size = 0, // 0 = use default
-        .id = 0,
-      },
-      LWS_PROTOCOL_LIST_TERM
-    };
-    
-    // Create LibWebSockets context
-    struct lws_context_creation_info info;
-    std::memset(&info, 0, sizeof(info));
-    
-    info.port = CONTEXT_PORT_NO_LISTEN;
-    info.protocols = protocolsList;
-    info.gid = -1;
-    info.uid = -1;
-    info.options = LWS_SERVER_OPTION_DO_SSL_GLOBAL_INIT;
-
-    // For client connections, SSL/TLS configuration is done at connection time
-    // using LCCSCF_* flags in lws_client_connect_info (see below)
-
-    // Set CA cert path
-    // On iOS/macOS, try to get bundled CA cert automatically
-    // On other platforms, use provided path or nullptr
-    const char* caCertPath = nullptr;
-
-    if (!_caPath.empty()) {
-      caCertPath = _caPath.c_str();
-      printf("[WebSocket] Using provided CA cert: %s\n", _caPath.c_str());
-    } else {
-      #if defined(__APPLE__) || defined(__ANDROID__)
-      caCertPath = getRealTimeNitroCACertPath();
-      if (caCertPath) {
-        // Store the bundled cert path so the rest of the code knows we have a CA cert
-        _caPath = caCertPath;
-        printf("[WebSocket] Using bundled CA cert: %s\n", caCertPath);
+  // Explicit protocols argument wins over options.protocols
+  const auto& protocolList = protocols.has_value() ? protocols :
+    (options.has_value() ? options->protocols : std::nullopt);
+  std::string subprotocols;
+  if (protocolList.has_value()) {
+    for (const auto& protocol : protocolList.value()) {
+      if (!subprotocols.empty()) {
+        subprotocols += ", ";
       }
-      #endif
+      subprotocols += protocol;
     }
+  }
+  if (subprotocols.empty()) {
+    subprotocols = EventLoop::CLIENT_PROTOCOL;
+  }
+
+  // Supersede any existing connection. This happens before returning so
+  // the state is already CONNECTING when connect() returns, and send() can
+  // be queued straight away (see setQueueWhileConnecting)
+  cleanup();
 
+  // Set CA cert path
+  // On iOS/macOS, try to get bundled CA cert automatically
+  // On other platforms, use provided path or nullptr
+  std::string caPath = _caPath;
+  if (!caPath.empty()) {
+    printf("[WebSocket] Using provided CA cert: %s\n", caPath.c_str());
+  } else {
+    #if defined(__APPLE__) || defined(__ANDROID__)
+    const char* caCertPath = getRealTimeNitroCACertPath();
     if (caCertPath) {
-      info.client_ssl_ca_filepath = caCertPath;
-    } else {
-      info.client_ssl_ca_filepath = nullptr;
-      printf("[WebSocket] WARNING: No CA cert available - mbedTLS may fail SSL handshake\n");
+      // Handed to the loop so the connection knows we have a CA cert
+      caPath = caCertPath;
+      printf("[WebSocket] Using bundled CA cert: %s\n", caCertPath);
     }
+    #endif
+  }
 
-    // Enable per-message-deflate compression extension
-    // This can reduce bandwidth by 60-80% for text messages
-    static const struct lws_extension extensions[] = {
-      {
-        "permessage-deflate",
-        lws_extension_callback_pm_deflate,
-        "permessage-deflate"
-        "; client_no_context_takeover"
-        "; client_max_window_bits"
-      },
-      { nullptr, nullptr, nullptr }
-    };
-    info.extensions = extensions;
-
-    // Note: On mobile platforms (iOS/Android), CA certs are in system trust store
-    // LibWebSockets should automatically use them for SSL verification
-
-    // Enable LibWebSockets logging for debugging
-    // Always enable error and warning logs to help diagnose connection issues
-    // Note: On iOS/Android, these logs may go to system logs (use adb logcat or Xcode console)
-    lws_set_log_level(LLL_ERR | LLL_WARN | LLL_NOTICE | LLL_USER, nullptr);
+  if (caPath.empty()) {
+    printf("[WebSocket] WARNING: No CA cert available - mbedTLS may fail SSL handshake\n");
+  }
+
+  // A preconnected socket with the same URL, handshake and TLS settings is
+  // adopted instead of dialing. It lives on its own loop, so only sockets
+  // that are not yet bound to another loop can take it. Socket tuning is
+  // fixed once a socket connects, so it is part of the key
+  _warmKey = warmKey(endpointKey + '\n' + socketTuning.key(), subprotocols, headers);
+  auto warm = _parked ? nullptr : takeWarm(_warmKey, _loop);
+
+  // Pick the loop before publishing CONNECTING: close() uses _loop once
+  // it observes a non-CLOSED state. Reconnects stay on the same loop so
+  // its context and cached vhost (TLS state, CA store) are reused and
+  // only the client connection is recreated
+  try {
+    if (!_loop) {
+      _loop = warm ? warm->_loop : EventLoop::acquire(url);
+    }
+  } catch (...) {
+    return Promise<void>::rejected(std::current_exception());
+  }
+  auto connectStarted = std::chrono::steady_clock::now();
+  uint64_t generation;
+  {
+    std::lock_guard<std::mutex> lock(_lifecycleMutex);
+    generation = _generation.load();
+    _state = State::CONNECTING;
+    _endpointUrl.clear();
+  }
 
+  auto promise = Promise<void>::create();
+
+  {
     printf("[WebSocket] ========================================\n");
     printf("[WebSocket] Initializing connection to: %s\n", url.c_str());
-    printf("[WebSocket] Host: %s, Port: %d, Path: %s\n", _host.c_str(), _port, _path.c_str());
-    printf("[WebSocket] SSL: %s\n", _useSsl ? "ENABLED" : "DISABLED");
+    printf("[WebSocket] Host: %s, Port: %d, Path: %s\n", target.host.c_str(), target.port, target.path.c_str());
+    printf("[WebSocket] SSL: %s\n", target.useSsl ? "ENABLED" : "DISABLED");
     printf("[WebSocket] ========================================\n");
 
-    printf("[WebSocket] Creating LibWebSockets context...\n");
-    _context = lws_create_context(&info);
-    if (!_context) {
-      _state = State::CLOSED;
-      printf("[WebSocket] ❌ FAILED to create context!\n");
-      throw std::runtime_error("Failed to create WebSocket context - check LibWebSockets installation");
-    }
-    printf("[WebSocket] ✅ Context created successfully\n");
-    
-    // Setup connection info
-    struct lws_client_connect_info ccinfo;
-    std::memset(&ccinfo, 0, sizeof(ccinfo));
-
-    ccinfo.context = _context;
-    ccinfo.address = _host.c_str();
-    ccinfo.port = _port;
-    ccinfo.path = _path.c_str();
-    ccinfo.host = _host.c_str();
-    ccinfo.origin = _host.c_str();
-    ccinfo.protocol = protocolsList[0].name;
-
-    // SSL configuration
-    if (_useSsl) {
-      ccinfo.ssl_connection = LCCSCF_USE_SSL;
-
-      if (_caPath.empty()) {
-        // No CA certificate - disable verification (insecure, for development only)
-        ccinfo.ssl_connection |= LCCSCF_ALLOW_SELFSIGNED;
-        ccinfo.ssl_connection |= LCCSCF_SKIP_SERVER_CERT_HOSTNAME_CHECK;
-        ccinfo.ssl_connection |= LCCSCF_ALLOW_EXPIRED;
-        ccinfo.ssl_connection |= LCCSCF_ALLOW_INSECURE;
-        printf("[WebSocket] SSL enabled WITHOUT certificate verification (insecure)\n");
-      } else {
-        printf("[WebSocket] SSL enabled WITH certificate verification using: %s\n", _caPath.c_str());
+    // lws is not thread-safe: create the connection on the loop thread.
+    // The promise is settled from lws callbacks, so nothing here blocks
+    _loop->post([this, self = shared(), promise, timeoutMs, happyEyeballs, generation, connectStarted,
+                 url, caPath = std::move(caPath),
+                 endpoints = std::move(endpoints), endpointStrategy, failoverDelayMs, socketTuning,
+                 subprotocols = std::move(subprotocols),
+                 headers = std::move(headers),
+                 warm = std::move(warm)]() mutable {
+      // A later connect() already superseded this one
+      if (generation != _generation.load()) {
+        promise->reject(std::make_exception_ptr(std::runtime_error("Connection aborted")));
+        return;
       }
-    } else {
-      printf("[WebSocket] SSL disabled - using plain WebSocket\n");
-      ccinfo.ssl_connection = 0; // Explicitly no SSL
-    }
-
-    // User data for callbacks
-    auto* userData = new WebSocketUserData{this};
-    ccinfo.userdata = userData;
-    ccinfo.pwsi = &_wsi;
-
-    // Initiate connection
-    printf("[WebSocket] 🔄 Initiating connection to %s:%d%s (SSL:%s)...\n",
-           _host.c_str(), _port, _path.c_str(), _useSsl ? "YES" : "NO");
-    printf("[WebSocket] Using SSL flags: 0x%x\n", ccinfo.ssl_connection);
-
-    _wsi = lws_client_connect_via_info(&ccinfo);
-    if (!_wsi) {
-      delete userData;
-      cleanup();
-      printf("[WebSocket] ❌ lws_client_connect_via_info() returned NULL\n");
-      printf("[WebSocket] This usually means:\n");
-      printf("[WebSocket]   1. DNS resolution failed for %s\n", _host.c_str());
-      printf("[WebSocket]   2. SSL/TLS configuration error\n");
-      printf("[WebSocket]   3. Out of memory\n");
-      printf("[WebSocket]   4. Invalid parameters\n");
-      printf("[WebSocket] Check system/Xcode console for LibWebSockets errors\n");
-
-      std::string errorMsg = "Failed to initiate WebSocket connection to " +
-                            _host + ":" + std::to_string(_port) +
-                            " - Check network connectivity, DNS resolution, and LibWebSockets logs above";
-      throw std::runtime_error(errorMsg);
-    }
-    printf("[WebSocket] ✅ Connection handle created, waiting for handshake...\n");
-    
-    // Start service thread
-    _running = true;
-    _serviceThread = std::thread([this]() {
-      serviceLoop();
+
+      {
+        std::lock_guard<std::mutex> lock(_lifecycleMutex);
+        _url = url;
+      }
+      _connectStarted = connectStarted;
+      _tlsCaPath = std::move(caPath);
+      _connectPromise = promise;
+      _subprotocols = std::move(subprotocols);
+      _handshakeHeaders = std::move(headers);
+      _connectTimeoutMs = timeoutMs;
+      _happyEyeballs = happyEyeballs;
+      _endpoints = std::move(endpoints);
+      _endpointStrategy = endpointStrategy;
+      _failoverDelayMs = failoverDelayMs;
+      _socketTuning = socketTuning;
+      _reconnectAttempt = 0;
+      if (warm && adoptWarm(self, *warm, generation)) {
+        return;
+      }
+      openConnection(self, generation);
     });
-    
-    // Note: This returns immediately after initiating connection
-    // The actual "connected" state is signaled via onOpen callback
-  });
+  }
+
+  // Settled by the lws callbacks once the handshake completes or fails
+  return promise;
 }
 
-// ============================================================
-// Service Loop (runs in separate thread)
-// ============================================================
+void HybridWebSocket::openConnection(const std::shared_ptr<HybridWebSocket>& self, uint64_t generation) {
+  _rxMessage.clear();
+  _link = std::make_shared<Link>();
+  _link->connectTimer.link = _link.get();
+  _link->closeTimer.link = _link.get();
+  _link->reconnectTimer.link = _link.get();
+  _link->raceTimer.link = _link.get();
+  _link->parkTimer.link = _link.get();
+  _link->pongTimer.link = _link.get();
+  _closeRequested = false;
+  _closeTimedOut = false;
+  _pongTimedOut = false;
+  _peerCloseCode = 0;
+  _peerCloseReason.clear();
+  _link->owner = self;
+  _link->loop = _loop;
+  _link->generation = generation;
+
+  // Connections with the same CA path and receive buffer size share a
+  // vhost, so TLS setup and CA parsing are not repeated per socket
+  bool reused = false;
+  struct lws_vhost* vhost = _loop->vhostFor(
+    EventLoop::VhostConfig{_tlsCaPath, _rxBufferSize},
+    HybridWebSocket::websocketCallback,
+    reused
+  );
+  _vhostReused = reused;
+  if (!vhost) {
+    failConnection(*_link, "Failed to create WebSocket context - check LibWebSockets installation");
+    return;
+  }
 
-void HybridWebSocket::serviceLoop() {
-  // Adaptive polling: start aggressive, back off when idle
-  int pollTimeout = 1; // Start with 1ms for low latency
-  int idleCount = 0;
-  const int MAX_IDLE_COUNT = 10;
-  const int MAX_TIMEOUT = 50; // Max 50ms when idle
+  _link->vhost = vhost;
 
-  while (_running && _context) {
-    // Service the connection with adaptive timeout
-    int result = lws_service(_context, pollTimeout);
+  // The deadline covers DNS and every attempt of a race
+  if (_connectTimeoutMs.has_value()) {
+    lws_sul_schedule(_loop->context(), 0, &_link->connectTimer.sul,
+                     HybridWebSocket::onConnectTimeout,
+                     static_cast<lws_usec_t>(_connectTimeoutMs.value() * LWS_US_PER_MS));
+  }
 
-    if (result < 0) {
-      break; // Service error
-    }
+  // Host names never reach lws: its resolver would block the loop (or,
+  // with lws async DNS, bypass the system's DNS configuration)
+  resolveEndpoints(_link);
+}
 
-    // Adaptive polling: increase timeout when idle to save CPU
-    if (result == 0) {
-      idleCount++;
-      if (idleCount > MAX_IDLE_COUNT && pollTimeout < MAX_TIMEOUT) {
-        pollTimeout = std::min(pollTimeout * 2, MAX_TIMEOUT);
-      }
+bool HybridWebSocket::startAttempt(Link& link, const Link::Target& target) {
+  const Endpoint& endpoint = _endpoints[target.endpoint];
+
+  // Setup connection info
+  struct lws_client_connect_info ccinfo;
+  std::memset(&ccinfo, 0, sizeof(ccinfo));
+
+  ccinfo.context = _loop->context();
+  ccinfo.vhost = link.vhost;
+  // The address may be an IP literal from the race; Host, SNI and
+  // certificate checks always use the host name
+  ccinfo.address = target.address.c_str();
+  ccinfo.port = endpoint.port;
+  ccinfo.path = endpoint.path.c_str();
+  ccinfo.host = endpoint.host.c_str();
+  ccinfo.origin = endpoint.host.c_str();
+  // Requested sub-protocols go on the wire; the connection still binds
+  // to our own protocol handler on the vhost
+  ccinfo.protocol = _subprotocols.c_str();
+  ccinfo.local_protocol_name = EventLoop::CLIENT_PROTOCOL;
+
+  // SSL configuration
+  if (endpoint.useSsl) {
+    ccinfo.ssl_connection = LCCSCF_USE_SSL;
+
+    if (_tlsCaPath.empty()) {
+      // No CA certificate - disable verification (insecure, for development only)
+      ccinfo.ssl_connection |= LCCSCF_ALLOW_SELFSIGNED;
+      ccinfo.ssl_connection |= LCCSCF_SKIP_SERVER_CERT_HOSTNAME_CHECK;
+      ccinfo.ssl_connection |= LCCSCF_ALLOW_EXPIRED;
+      ccinfo.ssl_connection |= LCCSCF_ALLOW_INSECURE;
+      printf("[WebSocket] SSL enabled WITHOUT certificate verification (insecure)\n");
     } else {
-      idleCount = 0;
-      pollTimeout = 1; // Reset to low latency when active
+      printf("[WebSocket] SSL enabled WITH certificate verification using: %s\n", _tlsCaPath.c_str());
     }
+  } else {
+    printf("[WebSocket] SSL disabled - using plain WebSocket\n");
+    ccinfo.ssl_connection = 0; // Explicitly no SSL
+  }
 
-    // Process send queue - BATCH PROCESS multiple messages
-    if (_wsi && _state == State::OPEN) {
-      // Try lock first to avoid blocking if queue is being modified
-      std::unique_lock<std::mutex> lock(_sendMutex, std::try_to_lock);
-      if (!lock.owns_lock()) {
-        continue; // Skip this iteration if locked
-      }
-
-      // Process up to 64 messages per iteration (increased batch size)
-      int batchCount = 0;
-      const int MAX_BATCH_SIZE = 64;
+  // Callbacks find this instance through the link; detach() clears it
+  // so a detached wsi never calls back into us
+  ccinfo.opaque_user_data = &link;
 
-      while (!_sendQueue.empty() && batchCount < MAX_BATCH_SIZE) {
-        auto& msg = _sendQueue.front();
+  // Initiate connection
+  printf("[WebSocket] 🔄 Initiating connection to %s:%d%s via %s (SSL:%s)...\n",
+         endpoint.host.c_str(), endpoint.port, endpoint.path.c_str(), target.address.c_str(),
+         endpoint.useSsl ? "YES" : "NO");
+  printf("[WebSocket] Using SSL flags: 0x%x\n", ccinfo.ssl_connection);
 
-        // Prepare buffer with LWS_PRE padding
-        std::vector<uint8_t> buffer(LWS_PRE + msg.data.size());
-        std::copy(msg.data.begin(), msg.data.end(), buffer.begin() + LWS_PRE);
+  struct lws* wsi = lws_client_connect_via_info(&ccinfo);
+  if (!wsi) {
+    printf("[WebSocket] ❌ lws_client_connect_via_info() returned NULL\n");
+    return false;
+  }
+  auto now = std::chrono::steady_clock::now();
+  if (!link.wsi) {
+    link.wsi = wsi;
+    link.endpoint = target.endpoint;
+    link.started = now;
+  } else {
+    link.racers.push_back(Link::Attempt{wsi, target.endpoint, now});
+  }
+  _loop->connectionOpened();
+  printf("[WebSocket] ✅ Connection handle created, waiting for handshake...\n");
+  return true;
+}
 
-        // Determine write protocol based on message type
-        lws_write_protocol writeProtocol = msg.isBinary ? LWS_WRITE_BINARY : LWS_WRITE_TEXT;
+bool HybridWebSocket::startNext(Link& link) {
+  while (!link.pending.empty()) {
+    Link::Target target = std::move(link.pending.front());
+    link.pending.pop_front();
+    // A target that cannot even start is skipped right away
+    if (startAttempt(link, target) && link.raceDelayMs > 0) {
+      break;
+    }
+  }
+  if (!link.pending.empty()) {
+    lws_sul_schedule(_loop->context(), 0, &link.raceTimer.sul,
+                     HybridWebSocket::onRaceTimer,
+                     static_cast<lws_usec_t>(link.raceDelayMs) * LWS_US_PER_MS);
+  }
+  return link.wsi || !link.racers.empty();
+}
 
-        // Unlock during write to avoid blocking senders
-        lock.unlock();
+void HybridWebSocket::failConnection(Link& link, const std::string& error) {
+  if (!transition(link, State::CLOSED)) {
+    return;
+  }
+  // Reconnect attempts have no promise to reject
+  bool pending = _connectPromise != nullptr;
+  settleConnect(std::make_exception_ptr(std::runtime_error(error)));
+  if (!pending) {
+    emitError(error);
+  }
+  scheduleReconnect(link);
+}
 
-        // Write to WebSocket
-        int written = lws_write(
-          _wsi,
-          buffer.data() + LWS_PRE,
-          msg.data.size(),
-          writeProtocol
-        );
+void HybridWebSocket::settleConnect(std::exception_ptr error) {
+  if (_link) {
+    lws_sul_cancel(&_link->connectTimer.sul);
+  }
 
-        lock.lock();
+  auto promise = std::move(_connectPromise);
+  _connectPromise = nullptr;
+  if (!promise) {
+    return;
+  }
+  if (error) {
+    promise->reject(error);
+  } else {
+    promise->resolve();
+  }
+}
 
-        if (written == static_cast<int>(msg.data.size())) {
-          _sendQueue.pop();
-          batchCount++;
-          // Track performance metrics
-          _messagesSent.fetch_add(1, std::memory_order_relaxed);
-          _bytesSent.fetch_add(msg.data.size(), std::memory_order_relaxed);
-        } else {
-          // Write failed, stop batch processing
-          break;
-        }
-      }
-    }
+void HybridWebSocket::onConnectTimeout(lws_sorted_usec_list_t* sul) {
+  auto* link = reinterpret_cast<Link::Timer*>(sul)->link;
+  auto self = link->owner.lock();
+  // Armed only while an attempt is pending; settleConnect() cancels it
+  if (!self || !self->transition(*link, State::CLOSED)) {
+    return;
   }
+  auto* ws = self.get();
+
+  auto elapsed = std::chrono::steady_clock::now() - ws->_connectStarted;
+  std::string error = "Connection timed out after " +
+    std::to_string(static_cast<long long>(std::chrono::duration<double, std::milli>(elapsed).count())) + " ms";
+  printf("[WebSocket] %s: %s\n", error.c_str(), ws->_url.c_str());
+
+  // Abandon the attempt the same way cleanup() does
+  detach(*link);
+  ws->settleConnect(std::make_exception_ptr(std::runtime_error(error)));
+  ws->emitError(error);
+  ws->scheduleReconnect(*link);
 }
 
 // ============================================================
-// Send
+// Endpoints
 // ============================================================
 
-void HybridWebSocket::send(const std::string& message) {
-  if (_state != State::OPEN) {
-    throw std::runtime_error("WebSocket is not open");
-  }
+namespace {
 
-  QueuedMessage msg;
-  msg.data.reserve(message.size()); // Pre-allocate to avoid reallocation
-  msg.data.assign(message.begin(), message.end());
-  msg.isBinary = false;
+// Handshake time per endpoint URL (ms), shared by all sockets so a new
+// session starts from what earlier ones measured. Smoothed, since one slow
+// handshake should not reorder a whole endpoint list
+constexpr double LATENCY_WEIGHT = 0.3;
+// Recorded for an endpoint whose attempt failed; a later success replaces it
+constexpr double FAILED_LATENCY_MS = 10000;
 
-  {
-    std::lock_guard<std::mutex> lock(_sendMutex);
-    _sendQueue.push(std::move(msg));
-  }
+std::mutex latencyMutex;
+std::unordered_map<std::string, double> endpointLatencies;
 
-  // Wake up service thread only if needed (when idle)
-  // lws_cancel_service is relatively expensive, so avoid when not needed
-  if (_context) {
-    lws_cancel_service(_context);
+void recordEndpointLatency(const std::string& url, double ms) {
+  std::lock_guard<std::mutex> lock(latencyMutex);
+  auto [it, inserted] = endpointLatencies.try_emplace(url, ms);
+  if (!inserted && it->second < FAILED_LATENCY_MS) {
+    it->second += LATENCY_WEIGHT * (ms - it->second);
+  } else {
+    it->second = ms;
   }
 }
 
-void HybridWebSocket::sendBinary(const std::shared_ptr<ArrayBuffer>& data) {
-  if (_state != State::OPEN) {
-    throw std::runtime_error("WebSocket is not open");
-  }
+void penalizeEndpoint(const std::string& url) {
+  std::lock_guard<std::mutex> lock(latencyMutex);
+  double& ms = endpointLatencies[url];
+  ms = std::max(ms, FAILED_LATENCY_MS);
+}
 
-  const uint8_t* bytes = data->data();
-  size_t size = data->size();
+} // namespace
 
-  QueuedMessage msg;
-  msg.data.reserve(size); // Pre-allocate to avoid reallocation
-  msg.data.assign(bytes, bytes + size);
-  msg.isBinary = true;
+HybridWebSocket::EndpointStrategy HybridWebSocket::parseEndpointStrategy(const std::string& name) {
+  if (name == "priority") {
+    return EndpointStrategy::PRIORITY;
+  }
+  if (name == "latency") {
+    return EndpointStrategy::LATENCY;
+  }
+  if (name == "race") {
+    return EndpointStrategy::RACE;
+  }
+  throw std::invalid_argument("Unknown endpoint strategy '" + name + "' (expected 'priority', 'latency' or 'race')");
+}
 
-  {
-    std::lock_guard<std::mutex> lock(_sendMutex);
-    _sendQueue.push(std::move(msg));
+std::deque<HybridWebSocket::Link::Target> HybridWebSocket::endpointTargets() const {
+  std::deque<Link::Target> targets;
+  for (size_t i = 0; i < _endpoints.size(); i++) {
+    targets.push_back(Link::Target{_endpoints[i].host, i});
+  }
+  if (_endpointStrategy != EndpointStrategy::LATENCY) {
+    return targets;
   }
 
-  // Wake up service thread
-  if (_context) {
-    lws_cancel_service(_context);
+  // Fastest first; unmeasured endpoints keep their order after measured
+  // ones, but ahead of endpoints that failed
+  std::vector<double> latency(_endpoints.size(), FAILED_LATENCY_MS - 1);
+  {
+    std::lock_guard<std::mutex> lock(latencyMutex);
+    for (size_t i = 0; i < _endpoints.size(); i++) {
+      auto it = endpointLatencies.find(_endpoints[i].url);
+      if (it != endpointLatencies.end()) {
+        latency[i] = it->second;
+      }
+    }
   }
+  std::stable_sort(targets.begin(), targets.end(), [&](const Link::Target& a, const Link::Target& b) {
+    return latency[a.endpoint] < latency[b.endpoint];
+  });
+  return targets;
 }
 
 // ============================================================
-// Close
+// Address resolution and Happy Eyeballs (loop thread)
 // ============================================================
 
-void HybridWebSocket::close(
-    const std::optional<double> code, 
-    const std::optional<std::string>& reason) {
-  
-  if (_state == State::CLOSED || _state == State::CLOSING) {
+void HybridWebSocket::resolveEndpoints(const std::shared_ptr<Link>& link) {
+  // Literal and cached hosts need no lookup
+  std::vector<std::string> lookups;
+  for (const auto& endpoint : _endpoints) {
+    const std::string& host = endpoint.host;
+    if (DnsResolver::isLiteral(host) || link->resolved.count(host) ||
+        std::find(lookups.begin(), lookups.end(), host) != lookups.end()) {
+      continue;
+    }
+    if (auto addresses = DnsResolver::cached(host)) {
+      link->resolved[host] = std::move(addresses.value());
+    } else {
+      lookups.push_back(host);
+    }
+  }
+  if (lookups.empty()) {
+    startTargets(*link);
     return;
   }
-  
-  _state = State::CLOSING;
-  
-  if (_wsi) {
-    int closeCode = code.has_value() ? 
-                   static_cast<int>(code.value()) : 
-                   LWS_CLOSE_STATUS_NORMAL;
-    std::string closeReason = reason.value_or("");
-    
-    lws_close_reason(
-      _wsi, 
-      static_cast<lws_close_status>(closeCode),
-      reinterpret_cast<unsigned char*>(const_cast<char*>(closeReason.c_str())),
-      closeReason.length()
-    );
-    lws_callback_on_writable(_wsi);
+
+  // Answers arrive on resolver threads and are handed back to the loop
+  link->dnsPending = static_cast<int>(lookups.size());
+  std::weak_ptr<Link> weak = link;
+  EventLoop* loop = _loop;
+  for (const auto& host : lookups) {
+    DnsResolver::resolve(host, [weak, loop, host](const DnsResolver::Addresses& addresses) {
+      loop->post([weak, host, addresses]() {
+        auto link = weak.lock();
+        auto self = link ? link->owner.lock() : nullptr;
+        if (!self || !self->isCurrent(*link) || link != self->_link || link->dnsPending == 0) {
+          return;
+        }
+        link->resolved[host] = addresses;
+        if (--link->dnsPending == 0) {
+          self->startTargets(*link);
+        }
+      });
+    });
   }
-  
-  // Stop service loop
-  _running = false;
 }
 
-// ============================================================
-// Cleanup
-// ============================================================
+void HybridWebSocket::startTargets(Link& link) {
+  // Addresses lws can dial; without IPv6 support only IPv4 is usable
+  auto addressesOf = [&](const Endpoint& endpoint) {
+    DnsResolver::Addresses addresses;
+    if (DnsResolver::isLiteral(endpoint.host)) {
+      addresses.push_back(endpoint.host);
+    } else if (auto it = link.resolved.find(endpoint.host); it != link.resolved.end()) {
+      addresses = it->second;
+    }
+#if !defined(LWS_WITH_IPV6)
+    addresses.erase(std::remove_if(addresses.begin(), addresses.end(), DnsResolver::isIpv6), addresses.end());
+#endif
+    return addresses;
+  };
+
+  const Endpoint& primary = _endpoints.front();
+  auto primaryAddresses = addressesOf(primary);
+  if (_endpoints.size() == 1) {
+    auto ipv6 = std::find_if(primaryAddresses.begin(), primaryAddresses.end(), DnsResolver::isIpv6);
+    auto ipv4 = std::find_if_not(primaryAddresses.begin(), primaryAddresses.end(), DnsResolver::isIpv6);
+    if (_happyEyeballs && ipv6 != primaryAddresses.end() && ipv4 != primaryAddresses.end()) {
+      // IPv6 first; IPv4 joins after the stagger, or at once if IPv6 fails
+      link.pending.push_back(Link::Target{*ipv6, 0});
+      link.pending.push_back(Link::Target{*ipv4, 0});
+      link.raceDelayMs = HAPPY_EYEBALLS_DELAY_MS;
+    } else {
+      // One address after another, in the system's preference order
+      for (const auto& address : primaryAddresses) {
+        link.pending.push_back(Link::Target{address, 0});
+      }
+      link.raceDelayMs = _failoverDelayMs;
+    }
+  } else {
+    // Endpoint lists race the endpoints, each on its preferred address
+    for (auto& target : endpointTargets()) {
+      const Endpoint& endpoint = _endpoints[target.endpoint];
+      auto addresses = addressesOf(endpoint);
+      if (addresses.empty()) {
+        penalizeEndpoint(endpoint.url);
+        continue;
+      }
+      target.address = addresses.front();
+      link.pending.push_back(std::move(target));
+    }
+    link.raceDelayMs = _endpointStrategy == EndpointStrategy::RACE ? 0 : _failoverDelayMs;
+  }
 
-void HybridWebSocket::cleanup() {
-  _running = false;
-  
-  if (_serviceThread.joinable()) {
-    _serviceThread.join();
+  if (link.pending.empty()) {
+    failConnection(link, "DNS resolution failed for " + primary.host);
+    return;
   }
-  
-  if (_context) {
-    lws_context_destroy(_context);
-    _context = nullptr;
+  if (!startNext(link)) {
+    printf("[WebSocket] This usually means:\n");
+    printf("[WebSocket]   1. SSL/TLS configuration error\n");
+    printf("[WebSocket]   2. Out of memory\n");
+    printf("[WebSocket]   3. Invalid parameters\n");
+    printf("[WebSocket] Check system/Xcode console for LibWebSockets errors\n");
+
+    std::string errorMsg = "Failed to initiate WebSocket connection to " +
+                          primary.host + ":" + std::to_string(primary.port) +
+                          " - Check network connectivity and LibWebSockets logs above";
+    failConnection(link, errorMsg);
   }
-  
-  _wsi = nullptr;
-  _state = State::CLOSED;
-  
-  std::lock_guard<std::mutex> lock(_sendMutex);
-  while (!_sendQueue.empty()) {
-    _sendQueue.pop();
+}
+
+void HybridWebSocket::onRaceTimer(lws_sorted_usec_list_t* sul) {
+  auto* link = reinterpret_cast<Link::Timer*>(sul)->link;
+  auto self = link->owner.lock();
+  if (!self || !self->isCurrent(*link) || link->pending.empty()) {
+    return;
   }
+  #ifdef DEBUG
+  printf("[WebSocket] No handshake after %d ms, starting %s\n",
+         link->raceDelayMs, link->pending.front().address.c_str());
+  #endif
+  // Attempts already in flight keep running
+  self->startNext(*link);
 }
 
-// ============================================================
-// Getters / Setters
-// ============================================================
+void HybridWebSocket::finishRace(Link& link, struct lws* wsi) {
+  lws_sul_cancel(&link.raceTimer.sul);
+  link.pending.clear();
+  if (wsi != link.wsi) {
+    for (auto& racer : link.racers) {
+      if (racer.wsi == wsi) {
+        std::swap(link.wsi, racer.wsi);
+        std::swap(link.endpoint, racer.endpoint);
+        std::swap(link.started, racer.started);
+        _raceFallbacks.fetch_add(1, std::memory_order_relaxed);
+        break;
+      }
+    }
+  }
+  for (auto& racer : std::exchange(link.racers, {})) {
+    releaseAttempt(link, racer.wsi);
+    lws_set_timeout(racer.wsi, PENDING_TIMEOUT_USER_OK, LWS_TO_KILL_ASYNC);
+  }
 
-void HybridWebSocket::setPingInterval(double intervalMs) {
-  _pingIntervalMs = static_cast<int>(intervalMs);
-  // Note: Actual ping sending is handled in the service loop
-  // We do NOT use lws_set_timeout here as that would close the connection
+  // An adopted preconnected link was measured when it opened
+  const std::string& url = _endpoints[link.endpoint].url;
+  if (link.openedAt == std::chrono::steady_clock::time_point{}) {
+    recordEndpointLatency(url,
+      std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - link.started).count());
+  }
+  std::lock_guard<std::mutex> lock(_lifecycleMutex);
+  _endpointUrl = url;
 }
 
-void HybridWebSocket::setCAPath(const std::string& path) {
-  _caPath = path;
-}
+bool HybridWebSocket::dropAttempt(Link& link, struct lws* wsi) {
+  size_t endpoint;
+  if (wsi == link.wsi) {
+    endpoint = link.endpoint;
+    releaseAttempt(link, wsi);
+    link.wsi = nullptr;
+    if (!link.racers.empty()) {
+      link.wsi = link.racers.back().wsi;
+      link.endpoint = link.racers.back().endpoint;
+      link.started = link.racers.back().started;
+      link.racers.pop_back();
+    }
+  } else {
+    auto it = std::find_if(link.racers.begin(), link.racers.end(),
+                           [wsi](const Link::Attempt& racer) { return racer.wsi == wsi; });
+    if (it == link.racers.end()) {
+      // Failed inside lws_client_connect_via_info(): startAttempt() returns
+      // false and its caller moves on or fails the connection, so this
+      // error must not fail it a second time
+      return true;
+    }
+    endpoint = it->endpoint;
+    releaseAttempt(link, wsi);
+    link.racers.erase(it);
+  }
+  penalizeEndpoint(_endpoints[endpoint].url);
 
-double HybridWebSocket::getState() {
-  return static_cast<double>(_state.load());
+  // Fast failover: don't wait out the race delay once everything failed
+  if (!link.wsi && link.racers.empty() && !link.pending.empty()) {
+    lws_sul_cancel(&link.raceTimer.sul);
+    startNext(link);
+  }
+  return link.wsi || !link.racers.empty();
 }
 
-std::string HybridWebSocket::getUrl() {
-  return _url;
+void HybridWebSocket::releaseAttempt(Link& link, struct lws* wsi) {
+  lws_set_opaque_user_data(wsi, nullptr);
+  link.loop->connectionClosed();
 }
 
-void HybridWebSocket::setOnOpen(
-    const std::optional<std::function<void()>>& value) {
-  std::lock_guard<std::mutex> lock(_callbackMutex);
-  _onOpen = value;
+// ============================================================
+// Socket Tuning
+// ============================================================
+
+namespace {
+
+// Kernel limits (Linux; Apple accepts the same ranges)
+constexpr double MAX_KEEPALIVE_MS = 32767.0 * 1000;
+constexpr double MAX_KEEPALIVE_COUNT = 127;
+constexpr double MAX_SOCKET_BUFFER = 64.0 * 1024 * 1024;
+
+bool inRange(const std::optional<double>& value, double min, double max) {
+  return !value.has_value() || (value.value() >= min && value.value() <= max);
 }
 
-void HybridWebSocket::setOnMessage(
-    const std::optional<std::function<void(const std::string&)>>& value) {
-  std::lock_guard<std::mutex> lock(_callbackMutex);
-  _onMessage = value;
+// Whole seconds, rounded up so a short interval never becomes 0
+int ceilSeconds(double ms) {
+  return std::max(1, static_cast<int>(std::ceil(ms / 1000.0)));
 }
 
-void HybridWebSocket::setOnBinaryMessage(
-    const std::optional<std::function<void(const std::shared_ptr<ArrayBuffer>&)>>& value) {
-  std::lock_guard<std::mutex> lock(_callbackMutex);
-  _onBinaryMessage = value;
+} // namespace
+
+HybridWebSocket::SocketTuning HybridWebSocket::parseSocketOptions(const std::optional<SocketOptions>& options) {
+  SocketTuning tuning;
+  if (!options.has_value()) {
+    return tuning;
+  }
+  if (!inRange(options->sendBufferSize, 1, MAX_SOCKET_BUFFER) ||
+      !inRange(options->receiveBufferSize, 1, MAX_SOCKET_BUFFER)) {
+    throw std::invalid_argument("Socket buffer sizes must be between 1 and " +
+                                std::to_string(static_cast<int>(MAX_SOCKET_BUFFER)) + " bytes");
+  }
+  if (!inRange(options->keepAliveIdle, 1, MAX_KEEPALIVE_MS) ||
+      !inRange(options->keepAliveInterval, 1, MAX_KEEPALIVE_MS)) {
+    throw std::invalid_argument("Keep-alive idle and interval must be between 1 and " +
+                                std::to_string(static_cast<int>(MAX_KEEPALIVE_MS)) + " ms");
+  }
+  if (!inRange(options->keepAliveCount, 1, MAX_KEEPALIVE_COUNT)) {
+    throw std::invalid_argument("Keep-alive count must be between 1 and 127");
+  }
+  if (!inRange(options->userTimeout, 1, INT_MAX)) {
+    throw std::invalid_argument("User timeout must be a positive number of milliseconds");
+  }
+
+  tuning.noDelay = options->noDelay.value_or(true);
+  tuning.sendBufferSize = static_cast<int>(options->sendBufferSize.value_or(0));
+  tuning.receiveBufferSize = static_cast<int>(options->receiveBufferSize.value_or(0));
+  tuning.keepAlive = options->keepAlive;
+  tuning.keepAliveIdleS = options->keepAliveIdle.has_value() ? ceilSeconds(options->keepAliveIdle.value()) : 0;
+  tuning.keepAliveIntervalS = options->keepAliveInterval.has_value() ? ceilSeconds(options->keepAliveInterval.value()) : 0;
+  tuning.keepAliveCount = static_cast<int>(options->keepAliveCount.value_or(0));
+  tuning.userTimeoutMs = static_cast<int>(std::ceil(options->userTimeout.value_or(0)));
+  // Probe settings imply keep-alive unless it was turned off explicitly
+  if (!tuning.keepAlive.has_value() &&
+      (tuning.keepAliveIdleS > 0 || tuning.keepAliveIntervalS > 0 || tuning.keepAliveCount > 0)) {
+    tuning.keepAlive = true;
+  }
+  return tuning;
 }
 
-void HybridWebSocket::setOnError(
-    const std::optional<std::function<void(const std::string&)>>& value) {
-  std::lock_guard<std::mutex> lock(_callbackMutex);
-  _onError = value;
+std::string HybridWebSocket::SocketTuning::key() const {
+  std::ostringstream key;
+  key << noDelay << ' ' << sendBufferSize << ' ' << receiveBufferSize << ' '
+      << (keepAlive.has_value() ? static_cast<int>(keepAlive.value()) : -1) << ' '
+      << keepAliveIdleS << ' ' << keepAliveIntervalS << ' ' << keepAliveCount << ' '
+      << userTimeoutMs;
+  return key.str();
 }
 
-void HybridWebSocket::setOnClose(
-    const std::optional<std::function<void(double, const std::string&)>>& value) {
-  std::lock_guard<std::mutex> lock(_callbackMutex);
-  _onClose = value;
+void HybridWebSocket::applySocketTuning(const SocketTuning& tuning, lws_sockfd_type fd) {
+  auto set = [fd](int level, int name, int value, const char* label) {
+    if (setsockopt(fd, level, name, &value, sizeof(value)) != 0) {
+      printf("[WebSocket] Failed to set %s=%d: %s\n", label, value, strerror(errno));
+    }
+  };
+
+  // lws disables Nagle on its own; set it either way so `false` turns it back on
+  set(IPPROTO_TCP, TCP_NODELAY, tuning.noDelay ? 1 : 0, "TCP_NODELAY");
+  if (tuning.sendBufferSize > 0) {
+    set(SOL_SOCKET, SO_SNDBUF, tuning.sendBufferSize, "SO_SNDBUF");
+  }
+  if (tuning.receiveBufferSize > 0) {
+    set(SOL_SOCKET, SO_RCVBUF, tuning.receiveBufferSize, "SO_RCVBUF");
+  }
+
+  if (tuning.keepAlive.has_value()) {
+    set(SOL_SOCKET, SO_KEEPALIVE, tuning.keepAlive.value() ? 1 : 0, "SO_KEEPALIVE");
+  }
+  if (tuning.keepAlive.value_or(false)) {
+    if (tuning.keepAliveIdleS > 0) {
+      #if defined(__APPLE__)
+      set(IPPROTO_TCP, TCP_KEEPALIVE, tuning.keepAliveIdleS, "TCP_KEEPALIVE");
+      #else
+      set(IPPROTO_TCP, TCP_KEEPIDLE, tuning.keepAliveIdleS, "TCP_KEEPIDLE");
+      #endif
+    }
+    if (tuning.keepAliveIntervalS > 0) {
+      set(IPPROTO_TCP, TCP_KEEPINTVL, tuning.keepAliveIntervalS, "TCP_KEEPINTVL");
+    }
+    if (tuning.keepAliveCount > 0) {
+      set(IPPROTO_TCP, TCP_KEEPCNT, tuning.keepAliveCount, "TCP_KEEPCNT");
+    }
+  }
+
+  if (tuning.userTimeoutMs > 0) {
+    #if defined(TCP_USER_TIMEOUT)
+    set(IPPROTO_TCP, TCP_USER_TIMEOUT, tuning.userTimeoutMs, "TCP_USER_TIMEOUT");
+    #elif defined(TCP_RXT_CONNDROPTIME)
+    // Apple's closest equivalent counts seconds of unacknowledged retransmits
+    set(IPPROTO_TCP, TCP_RXT_CONNDROPTIME, ceilSeconds(tuning.userTimeoutMs), "TCP_RXT_CONNDROPTIME");
+    #else
+    printf("[WebSocket] TCP user timeout is not supported on this platform\n");
+    #endif
+  }
 }
 
 // ============================================================
-// LibWebSockets Callback Handler
+// Warm pool (preconnect)
 // ============================================================
 
-int HybridWebSocket::websocketCallback(
-    struct lws* wsi,
-    enum lws_callback_reasons reason,
-    void* user,
-    void* in,
+/**
+ * Holds frames a preconnected socket receives before it is adopted
+ */
+class HybridWebSocket::WarmBuffer : public NativeMessageSink {
+public:
+  struct Message {
+    std::vector<uint8_t> data;
+    bool isBinary;
+  };
+
+  bool onMessage(const uint8_t* data, size_t len, bool isBinary) override {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_bytes + len > MAX_BYTES) {
+      #ifdef DEBUG
+      printf("[WebSocket] Preconnect buffer full, dropping a %zu byte message\n", len);
+      #endif
+      return true;
+    }
+    _messages.push_back(Message{std::vector<uint8_t>(data, data + len), isBinary});
+    _bytes += len;
+    return true;
+  }
+
+  std::vector<Message> take() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _bytes = 0;
+    return std::exchange(_messages, {});
+  }
+
+private:
+  static constexpr size_t MAX_BYTES = 1024 * 1024;
+
+  std::mutex _mutex;
+  std::vector<Message> _messages;
+  size_t _bytes = 0;
+};
+
+namespace {
+
+struct WarmEntry {
+  std::string key;
+  std::shared_ptr<HybridWebSocket> socket;
+};
+
+// Preconnected sockets, oldest first
+std::mutex warmMutex;
+std::deque<WarmEntry> warmPool;
+
+} // namespace
+
+void HybridWebSocket::preconnect(const std::string& url, const std::optional<WebSocketOptions>& options) {
+  // A hidden socket runs the usual connect path (DNS, TCP, TLS, upgrade,
+  // Happy Eyeballs) and parks once open
+  auto donor = std::make_shared<HybridWebSocket>();
+  donor->_caPath = _caPath;
+  donor->_rxBufferSize = _rxBufferSize;
+  donor->_pingIntervalMs = _pingIntervalMs;
+  donor->_parked = true;
+  donor->_warmBuffer = std::make_shared<WarmBuffer>();
+  donor->addSink(donor->_warmBuffer);
+  auto connecting = donor->connect(url, std::nullopt, options);
+  // connect() rejects an invalid URL or options up front, without leaving
+  // CLOSED; rethrow its reason (the listener runs inline once settled)
+  if (donor->_state == State::CLOSED && !connecting->isPending()) {
+    std::exception_ptr error;
+    connecting->addOnRejectedListener([&error](const std::exception_ptr& e) { error = e; });
+    if (error) {
+      std::rethrow_exception(error);
+    }
+    throw std::invalid_argument("Invalid preconnect options for " + url);
+  }
+
+  // Evicted sockets are released outside the lock (see ~HybridWebSocket)
+  std::vector<std::shared_ptr<HybridWebSocket>> evicted;
+  std::lock_guard<std::mutex> lock(warmMutex);
+  warmPool.push_back(WarmEntry{donor->_warmKey, donor});
+  while (warmPool.size() > WARM_POOL_SIZE) {
+    evicted.push_back(std::move(warmPool.front().socket));
+    warmPool.pop_front();
+  }
+}
+
+std::string HybridWebSocket::warmKey(
+    const std::string& url,
+    const std::string& subprotocols,
+    std::vector<std::pair<std::string, std::string>> headers) const {
+  // Everything that shapes the handshake or the TLS setup
+  std::sort(headers.begin(), headers.end());
+  std::string key = url + '\n' + subprotocols + '\n' + _caPath + '\n' + std::to_string(_rxBufferSize);
+  for (const auto& [name, value] : headers) {
+    key += '\n' + name + ':' + value;
+  }
+  return key;
+}
+
+std::shared_ptr<HybridWebSocket> HybridWebSocket::takeWarm(const std::string& key, EventLoop* loop) {
+  std::shared_ptr<HybridWebSocket> found;
+  // Declared before the lock so they are released after it
+  std::vector<std::shared_ptr<HybridWebSocket>> dead;
+  std::lock_guard<std::mutex> lock(warmMutex);
+  for (auto it = warmPool.begin(); it != warmPool.end();) {
+    State state = it->socket->_state.load();
+    if (state == State::CLOSED || state == State::CLOSING) {
+      dead.push_back(std::move(it->socket));
+      it = warmPool.erase(it);
+    } else if (!found && it->key == key && (!loop || it->socket->_loop == loop)) {
+      found = std::move(it->socket);
+      it = warmPool.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  return found;
+}
+
+bool HybridWebSocket::adoptWarm(const std::shared_ptr<HybridWebSocket>& self, HybridWebSocket& donor, uint64_t generation) {
+  std::shared_ptr<Link> link = donor._link;
+  State donorState;
+  {
+    std::lock_guard<std::mutex> lock(donor._lifecycleMutex);
+    donorState = donor._state;
+    if (!link || !link->wsi || (donorState != State::CONNECTING && donorState != State::OPEN)) {
+      return false;
+    }
+    // The donor lets go of the link; its callbacks are ours from here on
+    donor._generation.fetch_add(1, std::memory_order_acq_rel);
+    donor._state = State::CLOSED;
+  }
+  donor._link.reset();
+  donor._connectPromise = nullptr;
+  donor.removeSink(donor._warmBuffer);
+  lws_sul_cancel(&link->parkTimer.sul);
+
+  _link = link;
+  link->owner = self;
+  link->generation = generation;
+  _rxMessage = std::move(donor._rxMessage);
+  _rxIsBinary = donor._rxIsBinary;
+  _closeRequested = false;
+  _closeTimedOut = false;
+  _pongTimedOut = false;
+  _peerCloseCode = 0;
+  _peerCloseReason.clear();
+  _vhostReused = donor._vhostReused.load();
+  _warmAdopted.fetch_add(1, std::memory_order_relaxed);
+  #ifdef DEBUG
+  printf("[WebSocket] Adopted preconnected socket for %s\n", _url.c_str());
+  #endif
+
+  if (donorState == State::CONNECTING) {
+    // Still handshaking: our deadline replaces the donor's
+    lws_sul_cancel(&link->connectTimer.sul);
+    if (_connectTimeoutMs.has_value()) {
+      lws_sul_schedule(_loop->context(), 0, &link->connectTimer.sul,
+                       HybridWebSocket::onConnectTimeout,
+                       static_cast<lws_usec_t>(_connectTimeoutMs.value() * LWS_US_PER_MS));
+    }
+    return true;
+  }
+
+  if (onEstablished(*link, link->wsi) < 0) {
+    lws_set_timeout(link->wsi, PENDING_TIMEOUT_USER_OK, LWS_TO_KILL_ASYNC);
+    return true;
+  }
+  // Deliver what arrived while parked, in order
+  for (auto& message : donor._warmBuffer->take()) {
+    dispatchMessage(message.data.data(), message.data.size(), message.isBinary);
+  }
+  return true;
+}
+
+void HybridWebSocket::onParkTimeout(lws_sorted_usec_list_t* sul) {
+  auto* link = reinterpret_cast<Link::Timer*>(sul)->link;
+  auto self = link->owner.lock();
+  if (!self || !self->isCurrent(*link)) {
+    return;
+  }
+
+  #ifdef DEBUG
+  printf("[WebSocket] Preconnected socket unused for %d ms, closing: %s\n", WARM_TTL_MS, self->_url.c_str());
+  #endif
+  {
+    std::lock_guard<std::mutex> lock(warmMutex);
+    for (auto it = warmPool.begin(); it != warmPool.end(); ++it) {
+      if (it->socket == self) {
+        warmPool.erase(it);
+        break;
+      }
+    }
+  }
+  self->close(LWS_CLOSE_STATUS_GOINGAWAY, std::nullopt);
+}
+
+// ============================================================
+// Reconnect (loop thread)
+// ============================================================
+
+void HybridWebSocket::scheduleReconnect(Link& link) {
+  // close() and superseded links never reconnect
+  if (_closeRequested || &link != _link.get()) {
+    return;
+  }
+  std::optional<ReconnectConfig> config;
+  {
+    std::lock_guard<std::mutex> lock(_reconnectMutex);
+    config = _reconnectConfig;
+  }
+  if (!config.has_value()) {
+    return;
+  }
+
+  // A connection that stayed up long enough starts a fresh backoff
+  auto now = std::chrono::steady_clock::now();
+  if (link.openedAt != std::chrono::steady_clock::time_point{} &&
+      std::chrono::duration<double, std::milli>(now - link.openedAt).count() >= config->stableAfterMs) {
+    _reconnectAttempt = 0;
+  }
+  if (config->maxAttempts > 0 && _reconnectAttempt >= config->maxAttempts) {
+    std::string error = "Reconnect gave up after " + std::to_string(_reconnectAttempt) + " attempts";
+    #ifdef DEBUG
+    printf("[WebSocket] %s: %s\n", error.c_str(), _url.c_str());
+    #endif
+    emitError(error);
+    return;
+  }
+
+  uint32_t attempt = ++_reconnectAttempt;
+  double delayMs = std::min(config->maxDelayMs,
+                            config->initialDelayMs * std::pow(config->multiplier, attempt - 1));
+  // Jitter spreads out clients that dropped together (e.g. a server restart)
+  if (config->jitter > 0) {
+    thread_local std::minstd_rand rng{std::random_device{}()};
+    std::uniform_real_distribution<double> spread(-config->jitter, config->jitter);
+    delayMs = std::max(0.0, delayMs * (1 + spread(rng)));
+  }
+
+  if (!transition(link, State::CONNECTING)) {
+    return;
+  }
+  lws_sul_schedule(link.loop->context(), 0, &link.reconnectTimer.sul,
+                   HybridWebSocket::onReconnectTimer,
+                   static_cast<lws_usec_t>(delayMs * LWS_US_PER_MS));
+  _reconnects.fetch_add(1, std::memory_order_relaxed);
+  #ifdef DEBUG
+  printf("[WebSocket] Reconnect attempt %u in %.0f ms: %s\n", attempt, delayMs, _url.c_str());
+  #endif
+
+  std::lock_guard<std::mutex> lock(_callbackMutex);
+  if (_onReconnect.has_value()) {
+    try {
+      _onReconnect.value()(static_cast<double>(attempt), delayMs);
+    } catch (...) {}
+  }
+}
+
+void HybridWebSocket::onReconnectTimer(lws_sorted_usec_list_t* sul) {
+  auto* link = reinterpret_cast<Link::Timer*>(sul)->link;
+  auto self = link->owner.lock();
+  // close() may have raced in; its loop task cancels the retry
+  if (!self || !self->isCurrent(*link) || link != self->_link.get() ||
+      self->_state != State::CONNECTING) {
+    return;
+  }
+  auto* ws = self.get();
+
+  // The timer lives in the old link, so keep it alive until we return
+  auto previous = std::move(ws->_link);
+  detach(*previous);
+  ws->_connectStarted = std::chrono::steady_clock::now();
+  ws->openConnection(self, previous->generation);
+}
+
+void HybridWebSocket::queueOpenMessages(const Link& link) {
+  std::vector<std::string> messages;
+  {
+    std::lock_guard<std::mutex> lock(_reconnectMutex);
+    messages = _openMessages;
+  }
+  if (messages.empty()) {
+    return;
+  }
+
+  std::queue<QueuedMessage> queue;
+  std::lock_guard<std::mutex> lock(_sendMutex);
+  for (auto& message : messages) {
+    QueuedMessage msg;
+    msg.data.assign(message.begin(), message.end());
+    msg.isBinary = false;
+    msg.generation = link.generation;
+    msg.seq = _nextSendSeq++;
+    queue.push(std::move(msg));
+  }
+  while (!_sendQueue.empty()) {
+    queue.push(std::move(_sendQueue.front()));
+    _sendQueue.pop();
+  }
+  _sendQueue.swap(queue);
+}
+
+void HybridWebSocket::setReconnectPolicy(const std::optional<ReconnectPolicy>& policy) {
+  if (!policy.has_value()) {
+    std::lock_guard<std::mutex> lock(_reconnectMutex);
+    _reconnectConfig.reset();
+    return;
+  }
+
+  ReconnectConfig config;
+  config.initialDelayMs = policy->initialDelay.value_or(config.initialDelayMs);
+  config.maxDelayMs = policy->maxDelay.value_or(config.maxDelayMs);
+  config.multiplier = policy->multiplier.value_or(config.multiplier);
+  config.jitter = policy->jitter.value_or(config.jitter);
+  config.stableAfterMs = policy->stableAfter.value_or(config.stableAfterMs);
+  double maxAttempts = policy->maxAttempts.value_or(0);
+
+  if (!(config.initialDelayMs >= 0) || !(config.maxDelayMs >= config.initialDelayMs)) {
+    throw std::invalid_argument("Reconnect delays must satisfy 0 <= initialDelay <= maxDelay");
+  }
+  if (!(config.multiplier >= 1)) {
+    throw std::invalid_argument("Reconnect multiplier must be >= 1");
+  }
+  if (!(config.jitter >= 0 && config.jitter <= 1)) {
+    throw std::invalid_argument("Reconnect jitter must be between 0 and 1");
+  }
+  if (!(maxAttempts >= 0 && maxAttempts <= UINT32_MAX) || !(config.stableAfterMs >= 0)) {
+    throw std::invalid_argument("Reconnect maxAttempts and stableAfter must be >= 0");
+  }
+  config.maxAttempts = static_cast<uint32_t>(maxAttempts);
+
+  std::lock_guard<std::mutex> lock(_reconnectMutex);
+  _reconnectConfig = config;
+}
+
+void HybridWebSocket::setOpenMessages(const std::vector<std::string>& messages) {
+  std::lock_guard<std::mutex> lock(_reconnectMutex);
+  _openMessages = messages;
+}
+
+// ============================================================
+// Send queue (loop thread)
+// ============================================================
+
+void HybridWebSocket::requestWrite() {
+  // One pending request is enough: the WRITEABLE callback drains the whole queue
+  if (_writeRequested.exchange(true, std::memory_order_acq_rel)) {
+    return;
+  }
+
+  _loop->post([this, self = shared()]() {
+    _writeRequested.store(false, std::memory_order_release);
+    if (_link && _link->wsi) {
+      lws_callback_on_writable(_link->wsi);
+    }
+  });
+}
+
+int HybridWebSocket::flushSendQueue(Link& link, struct lws* wsi) {
+  std::unique_lock<std::mutex> lock(_sendMutex);
+
+  // Process up to 64 messages per writable callback
+  int batchCount = 0;
+  const int MAX_BATCH_SIZE = 64;
+
+  while (!_sendQueue.empty() && batchCount < MAX_BATCH_SIZE) {
+    // Stop once the kernel buffer is full; lws calls back when it drains
+    if (lws_send_pipe_choked(wsi)) {
+      break;
+    }
+
+    auto& msg = _sendQueue.front();
+
+    // connect() or close() may have superseded this link since the last
+    // pass: drop what was queued for older connections and leave messages
+    // for the next one alone
+    if (msg.generation < link.generation) {
+      _sendQueue.pop();
+      continue;
+    }
+    if (msg.generation != link.generation) {
+      return 0;
+    }
+
+    // Encode queued objects here so the JS thread never pays for it
+    if (msg.value) {
+      try {
+        msg.data = msg.codec == Codec::MSGPACK ?
+                   BinaryCodec::encodeMsgPack(msg.value) :
+                   BinaryCodec::encodeCbor(msg.value);
+      } catch (const std::exception& e) {
+        std::string error = std::string("Failed to encode message: ") + e.what();
+        _sendQueue.pop();
+        lock.unlock();
+        emitError(error);
+        lock.lock();
+        continue;
+      }
+      msg.value.reset();
+    }
+
+    // Prepare buffer with LWS_PRE padding
+    size_t size = msg.data.size();
+    std::vector<uint8_t> buffer(LWS_PRE + size);
+    std::copy(msg.data.begin(), msg.data.end(), buffer.begin() + LWS_PRE);
+
+    // Determine write protocol based on message type
+    lws_write_protocol writeProtocol = msg.isBinary ? LWS_WRITE_BINARY : LWS_WRITE_TEXT;
+    uint64_t seq = msg.seq;
+
+    // Unlock during write to avoid blocking senders
+    lock.unlock();
+
+    // Write to WebSocket (lws buffers any unsent remainder itself)
+    int written = lws_write(
+      wsi,
+      buffer.data() + LWS_PRE,
+      size,
+      writeProtocol
+    );
+
+    lock.lock();
+
+    if (written < 0) {
+      return -1; // Socket error, close the connection
+    }
+    link.lastDataAt = std::chrono::steady_clock::now();
+
+    // The queue may have been cleared or refilled during the write
+    if (!_sendQueue.empty() && _sendQueue.front().seq == seq) {
+      _sendQueue.pop();
+    }
+    batchCount++;
+    // Track performance metrics
+    _messagesSent.fetch_add(1, std::memory_order_relaxed);
+    _bytesSent.fetch_add(size, std::memory_order_relaxed);
+  }
+
+  if (!_sendQueue.empty()) {
+    lws_callback_on_writable(wsi);
+    return 0;
+  }
+  if (_drainWaiters.empty()) {
+    return 0;
+  }
+  // lws still holds part of a frame; it calls back once that is written
+  if (lws_has_buffered_out(wsi)) {
+    lws_callback_on_writable(wsi);
+    return 0;
+  }
+
+  auto waiters = std::move(_drainWaiters);
+  _drainWaiters.clear();
+  lock.unlock();
+  for (auto& waiter : waiters) {
+    waiter(true);
+  }
+  return 0;
+}
+
+// ============================================================
+// Send
+// ============================================================
+
+void HybridWebSocket::ensureCanSend() {
+  State state = _state.load();
+  if (state == State::OPEN) {
+    return;
+  }
+  if (state == State::CONNECTING && _queueWhileConnecting) {
+    return;
+  }
+  throw std::runtime_error("WebSocket is not open");
+}
+
+void HybridWebSocket::enqueue(QueuedMessage&& msg) {
+  {
+    std::lock_guard<std::mutex> lock(_sendMutex);
+    msg.generation = _generation.load(std::memory_order_acquire);
+    msg.seq = _nextSendSeq++;
+    _sendQueue.push(std::move(msg));
+  }
+
+  // While CONNECTING the ESTABLISHED callback flushes the queue. It sets OPEN
+  // before flushing, so re-reading the state here cannot miss both paths
+  if (_state == State::OPEN) {
+    // Ask the loop to call back when the socket is writable
+    requestWrite();
+  }
+}
+
+void HybridWebSocket::send(const std::string& message) {
+  ensureCanSend();
+
+  QueuedMessage msg;
+  msg.data.reserve(message.size()); // Pre-allocate to avoid reallocation
+  msg.data.assign(message.begin(), message.end());
+  msg.isBinary = false;
+
+  enqueue(std::move(msg));
+}
+
+void HybridWebSocket::sendBinary(const std::shared_ptr<ArrayBuffer>& data) {
+  ensureCanSend();
+
+  const uint8_t* bytes = data->data();
+  size_t size = data->size();
+
+  QueuedMessage msg;
+  msg.data.reserve(size); // Pre-allocate to avoid reallocation
+  msg.data.assign(bytes, bytes + size);
+  msg.isBinary = true;
+
+  enqueue(std::move(msg));
+}
+
+void HybridWebSocket::sendMsgPack(const std::shared_ptr<AnyMap>& value) {
+  enqueueEncoded(value, Codec::MSGPACK);
+}
+
+void HybridWebSocket::sendCbor(const std::shared_ptr<AnyMap>& value) {
+  enqueueEncoded(value, Codec::CBOR);
+}
+
+void HybridWebSocket::enqueueEncoded(const std::shared_ptr<AnyMap>& value, Codec codec) {
+  ensureCanSend();
+
+  QueuedMessage msg;
+  msg.isBinary = true;
+  msg.value = value;
+  msg.codec = codec;
+
+  enqueue(std::move(msg));
+}
+
+// ============================================================
+// Close
+// ============================================================
+
+void HybridWebSocket::close(
+    const std::optional<double> code, 
+    const std::optional<std::string>& reason) {
+  
+  {
+    std::lock_guard<std::mutex> lock(_lifecycleMutex);
+    if (_state == State::CLOSED || _state == State::CLOSING) {
+      return;
+    }
+    _state = State::CLOSING;
+  }
+  
+  int closeCode = code.has_value() ? 
+                 static_cast<int>(code.value()) : 
+                 LWS_CLOSE_STATUS_NORMAL;
+  std::string closeReason = reason.value_or("");
+  // Control frame payloads are limited to 125 bytes, 2 of them the code
+  if (closeReason.size() > 123) {
+    closeReason.resize(123);
+  }
+  bool drain = _drainOnClose.load();
+  double timeoutMs = _closeTimeoutMs.load();
+
+  // The closing phase runs from WRITEABLE callbacks (see continueClose)
+  _loop->post([this, self = shared(), closeCode, closeReason = std::move(closeReason), drain, timeoutMs]() mutable {
+    if (!_link) {
+      return;
+    }
+    if (!_link->wsi) {
+      // Waiting on DNS or between reconnect attempts: nothing to close on
+      // the wire, so stop the timers and drop any lookup still in flight
+      _closeRequested = true;
+      if (transition(*_link, State::CLOSED)) {
+        detach(*_link);
+        settleConnect(std::make_exception_ptr(std::runtime_error("Connection closed")));
+        failDrainWaiters();
+      }
+      return;
+    }
+    _closeRequested = true;
+    _closeDrain = drain;
+    _closeCode = closeCode;
+    _closeReason = std::move(closeReason);
+    if (!drain) {
+      std::lock_guard<std::mutex> lock(_sendMutex);
+      while (!_sendQueue.empty()) {
+        _sendQueue.pop();
+      }
+    }
+
+    lws_sul_schedule(_loop->context(), 0, &_link->closeTimer.sul,
+                     HybridWebSocket::onCloseTimeout,
+                     static_cast<lws_usec_t>(timeoutMs * LWS_US_PER_MS));
+    lws_callback_on_writable(_link->wsi);
+  });
+}
+
+void HybridWebSocket::setCloseOptions(const CloseOptions& options) {
+  if (options.timeout.has_value() && !(options.timeout.value() > 0)) {
+    throw std::invalid_argument("Close timeout must be a positive number of milliseconds");
+  }
+  if (options.drain.has_value()) {
+    _drainOnClose = options.drain.value();
+  }
+  if (options.timeout.has_value()) {
+    _closeTimeoutMs = options.timeout.value();
+  }
+}
+
+int HybridWebSocket::continueClose(Link& link, struct lws* wsi) {
+  if (_closeDrain) {
+    if (flushSendQueue(link, wsi) < 0) {
+      return -1;
+    }
+    // flushSendQueue() asked for another WRITEABLE if anything is left
+    std::lock_guard<std::mutex> lock(_sendMutex);
+    if (!_sendQueue.empty()) {
+      return 0;
+    }
+  }
+  // Let lws finish a partially written frame before the close frame
+  if (lws_has_buffered_out(wsi)) {
+    lws_callback_on_writable(wsi);
+    return 0;
+  }
+
+  // Returning -1 sends the close frame; lws then waits for the peer's reply
+  lws_close_reason(
+    wsi,
+    static_cast<lws_close_status>(_closeCode),
+    reinterpret_cast<unsigned char*>(_closeReason.data()),
+    _closeReason.length()
+  );
+  return -1;
+}
+
+void HybridWebSocket::onCloseTimeout(lws_sorted_usec_list_t* sul) {
+  auto* link = reinterpret_cast<Link::Timer*>(sul)->link;
+  auto self = link->owner.lock();
+  if (!self || !self->isCurrent(*link) || !link->wsi) {
+    return;
+  }
+
+  printf("[WebSocket] Close handshake timed out, dropping connection: %s\n", self->_url.c_str());
+  self->_closeTimedOut = true;
+  // Not detached: CLIENT_CLOSED still runs and reports 1006
+  lws_set_timeout(link->wsi, PENDING_TIMEOUT_USER_OK, LWS_TO_KILL_ASYNC);
+}
+
+// ============================================================
+// Ping / pong (loop thread)
+// ============================================================
+
+int HybridWebSocket::sendPing(Link& link, struct lws* wsi) {
+  unsigned char buffer[LWS_PRE + 8];
+  uint64_t seq = ++link.pingSeq;
+  for (int i = 0; i < 8; i++) {
+    buffer[LWS_PRE + i] = static_cast<unsigned char>(seq >> (56 - 8 * i));
+  }
+  if (lws_write(wsi, &buffer[LWS_PRE], 8, LWS_WRITE_PING) < 8) {
+    return -1;
+  }
+  auto now = std::chrono::steady_clock::now();
+  link.awaitedSeq = seq;
+  link.pingSentAt = now;
+  // Traffic in between already kept the path open, so the pong would not
+  // show that the interval survives on its own
+  link.pingIdle = link.lastDataAt < link.quietSince &&
+                  now - link.quietSince >= std::chrono::milliseconds(pingIntervalMs());
+  link.quietSince = now;
+  _pingsSent.fetch_add(1, std::memory_order_relaxed);
+
+  // Measured from the oldest unanswered ping, so later pings don't push it out
+  int timeoutMs = _pongTimeoutMs.load();
+  if (timeoutMs > 0 && !link.pongDeadlineArmed) {
+    link.pongDeadlineArmed = true;
+    lws_sul_schedule(_loop->context(), 0, &link.pongTimer.sul,
+                     HybridWebSocket::onPongTimeout,
+                     static_cast<lws_usec_t>(timeoutMs) * LWS_US_PER_MS);
+  }
+
+  #ifdef DEBUG
+  printf("[WebSocket] Ping %llu sent (interval: %dms)\n", static_cast<unsigned long long>(seq), _pingIntervalMs);
+  #endif
+  return 0;
+}
+
+void HybridWebSocket::onPong(Link& link, const uint8_t* payload, size_t len) {
+  // Any pong proves the peer is alive
+  lws_sul_cancel(&link.pongTimer.sul);
+  link.pongDeadlineArmed = false;
+  link.lastRxAt = std::chrono::steady_clock::now();
+  _pongsReceived.fetch_add(1, std::memory_order_relaxed);
+
+  uint64_t seq = 0;
+  if (payload && len == 8) {
+    for (size_t i = 0; i < 8; i++) {
+      seq = (seq << 8) | payload[i];
+    }
+  }
+  // Unsolicited pongs and answers to superseded pings carry no RTT
+  if (seq == 0 || seq != link.awaitedSeq) {
+    return;
+  }
+  link.awaitedSeq = 0;
+
+  if (link.pingIdle) {
+    keepaliveConfirmed();
+  }
+
+  double rttMs = std::chrono::duration<double, std::milli>(link.lastRxAt - link.pingSentAt).count();
+  std::lock_guard<std::mutex> lock(_rttMutex);
+  if (_rttSamples.size() < RTT_WINDOW) {
+    _rttSamples.push_back(rttMs);
+  } else {
+    _rttSamples[_rttNext] = rttMs;
+  }
+  _rttNext = (_rttNext + 1) % RTT_WINDOW;
+  _lastRttMs = rttMs;
+
+  #ifdef DEBUG
+  printf("[WebSocket] Pong %llu: %.1f ms\n", static_cast<unsigned long long>(seq), rttMs);
+  #endif
+}
+
+void HybridWebSocket::onPongTimeout(lws_sorted_usec_list_t* sul) {
+  auto* link = reinterpret_cast<Link::Timer*>(sul)->link;
+  auto self = link->owner.lock();
+  link->pongDeadlineArmed = false;
+  if (!self || !self->isCurrent(*link) || !link->wsi) {
+    return;
+  }
+
+  printf("[WebSocket] No pong within %d ms, dropping connection: %s\n",
+         self->_pongTimeoutMs.load(), self->_url.c_str());
+  self->_pongTimeouts.fetch_add(1, std::memory_order_relaxed);
+  self->_pongTimedOut = true;
+  // Half-open: a close frame would never be answered. CLIENT_CLOSED still
+  // runs, reports 1006 and lets the reconnect policy take over
+  lws_set_timeout(link->wsi, PENDING_TIMEOUT_USER_OK, LWS_TO_KILL_ASYNC);
+}
+
+std::unordered_map<std::string, double> HybridWebSocket::getPingStats() {
+  std::vector<double> samples;
+  double lastRttMs;
+  int keepaliveMs = _keepaliveIntervalMs.load();
+  {
+    std::lock_guard<std::mutex> lock(_rttMutex);
+    samples = _rttSamples;
+    lastRttMs = _lastRttMs;
+  }
+
+  std::unordered_map<std::string, double> stats = {
+    {"pingsSent", static_cast<double>(_pingsSent.load(std::memory_order_relaxed))},
+    {"pongsReceived", static_cast<double>(_pongsReceived.load(std::memory_order_relaxed))},
+    {"pongTimeouts", static_cast<double>(_pongTimeouts.load(std::memory_order_relaxed))},
+    {"samples", static_cast<double>(samples.size())},
+    {"intervalMs", static_cast<double>(keepaliveMs > 0 ? keepaliveMs : _pingIntervalMs)},
+  };
+  if (samples.empty()) {
+    return stats;
+  }
+
+  std::sort(samples.begin(), samples.end());
+  double sum = 0;
+  for (double sample : samples) {
+    sum += sample;
+  }
+  // Nearest-rank percentile
+  size_t p99 = static_cast<size_t>(std::ceil(0.99 * samples.size())) - 1;
+  stats["lastRttMs"] = lastRttMs;
+  stats["minRttMs"] = samples.front();
+  stats["avgRttMs"] = sum / samples.size();
+  stats["p99RttMs"] = samples[p99];
+  return stats;
+}
+
+// ============================================================
+// Adaptive keep-alive
+// ============================================================
+
+namespace {
+
+// Pongs in a row before an interval counts as proven and the next is probed
+constexpr uint32_t KEEPALIVE_CONFIRMATIONS = 3;
+constexpr double KEEPALIVE_GROWTH = 1.5;
+// Stay this far below an interval that failed
+constexpr double KEEPALIVE_CEILING_MARGIN = 0.9;
+
+// Learned per "<network>|<host>:<port>", shared by all sockets
+struct LearnedKeepalive {
+  double provenMs = 0;   // longest interval that held
+  double ceilingMs = 0;  // shortest interval that failed (0 = none)
+};
+
+std::mutex keepaliveTableMutex;
+std::unordered_map<std::string, LearnedKeepalive> keepaliveTable;
+
+} // namespace
+
+int HybridWebSocket::pingIntervalMs() const {
+  return _activeKeepalive ? _keepaliveIntervalMs.load() : _pingIntervalMs;
+}
+
+void HybridWebSocket::startKeepalive(Link& link, struct lws* wsi) {
+  link.lastRxAt = std::chrono::steady_clock::now();
+  link.quietSince = link.lastRxAt;
+  {
+    std::lock_guard<std::mutex> lock(_keepaliveMutex);
+    _activeKeepalive = _keepaliveConfig;
+  }
+
+  if (_activeKeepalive) {
+    const auto& config = *_activeKeepalive;
+    const Endpoint& endpoint = _endpoints[link.endpoint];
+    _keepaliveKey = config.networkKey + "|" + endpoint.host + ":" + std::to_string(endpoint.port);
+    _keepaliveConfirmations = 0;
+
+    double intervalMs = _pingIntervalMs > 0 ? _pingIntervalMs : config.minIntervalMs;
+    {
+      std::lock_guard<std::mutex> lock(keepaliveTableMutex);
+      auto it = keepaliveTable.find(_keepaliveKey);
+      if (it != keepaliveTable.end() && it->second.provenMs > 0) {
+        intervalMs = it->second.provenMs;
+      }
+    }
+    _keepaliveIntervalMs = static_cast<int>(std::clamp(intervalMs, config.minIntervalMs, config.maxIntervalMs));
+  } else {
+    _keepaliveIntervalMs = 0;
+  }
+
+  int intervalMs = pingIntervalMs();
+  if (intervalMs > 0) {
+    lws_set_timer_usecs(wsi, static_cast<lws_usec_t>(intervalMs) * LWS_US_PER_MS);
+  }
+}
+
+void HybridWebSocket::keepaliveConfirmed() {
+  if (!_activeKeepalive || ++_keepaliveConfirmations < KEEPALIVE_CONFIRMATIONS) {
+    return;
+  }
+  _keepaliveConfirmations = 0;
+
+  double current = _keepaliveIntervalMs.load();
+  double next = std::min(current * KEEPALIVE_GROWTH, _activeKeepalive->maxIntervalMs);
+  {
+    std::lock_guard<std::mutex> lock(keepaliveTableMutex);
+    auto& learned = keepaliveTable[_keepaliveKey];
+    learned.provenMs = std::max(learned.provenMs, current);
+    if (learned.ceilingMs > 0) {
+      next = std::min(next, learned.ceilingMs * KEEPALIVE_CEILING_MARGIN);
+    }
+  }
+  if (next > current) {
+    _keepaliveIntervalMs = static_cast<int>(next);
+    #ifdef DEBUG
+    printf("[WebSocket] Keep-alive %s: %.0f ms held, probing %.0f ms\n", _keepaliveKey.c_str(), current, next);
+    #endif
+  }
+}
+
+void HybridWebSocket::keepaliveClosed(const Link& link) {
+  if (!_activeKeepalive || link.openedAt == std::chrono::steady_clock::time_point{}) {
+    return;
+  }
+  // Idle failure: the pong deadline fired, or the connection dropped
+  // abnormally after a whole interval without hearing from the peer.
+  // Anything else (our close, a server close, a quick network switch)
+  // says nothing about NAT timeouts
+  double current = _keepaliveIntervalMs.load();
+  double silentMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - link.lastRxAt).count();
+  bool abnormal = !_closeRequested && _peerCloseCode == 0;
+  if (!_pongTimedOut && !(abnormal && silentMs >= current)) {
+    return;
+  }
+
+  double next;
+  {
+    std::lock_guard<std::mutex> lock(keepaliveTableMutex);
+    auto& learned = keepaliveTable[_keepaliveKey];
+    learned.ceilingMs = learned.ceilingMs > 0 ? std::min(learned.ceilingMs, current) : current;
+    if (learned.provenMs > 0 && learned.provenMs < current) {
+      next = learned.provenMs;
+    } else {
+      // The proven interval failed too: the network got stricter
+      next = std::max(current / 2, _activeKeepalive->minIntervalMs);
+      learned.provenMs = next;
+    }
+  }
+  _keepaliveIntervalMs = static_cast<int>(next);
+  _keepaliveConfirmations = 0;
+  #ifdef DEBUG
+  printf("[WebSocket] Keep-alive %s: idle failure at %.0f ms, back to %.0f ms\n",
+         _keepaliveKey.c_str(), current, next);
+  #endif
+}
+
+void HybridWebSocket::setAdaptiveKeepalive(const std::optional<KeepalivePolicy>& policy) {
+  if (!policy.has_value()) {
+    std::lock_guard<std::mutex> lock(_keepaliveMutex);
+    _keepaliveConfig.reset();
+    return;
+  }
+
+  KeepaliveConfig config;
+  config.minIntervalMs = policy->minInterval.value_or(config.minIntervalMs);
+  config.maxIntervalMs = policy->maxInterval.value_or(config.maxIntervalMs);
+  config.networkKey = policy->networkKey.value_or("");
+  if (!(config.minIntervalMs > 0) || !(config.maxIntervalMs >= config.minIntervalMs)) {
+    throw std::invalid_argument("Keep-alive intervals must satisfy 0 < minInterval <= maxInterval");
+  }
+
+  // Applies from the next connection
+  std::lock_guard<std::mutex> lock(_keepaliveMutex);
+  _keepaliveConfig = config;
+}
+
+std::unordered_map<std::string, double> HybridWebSocket::getKeepaliveIntervals() {
+  std::unordered_map<std::string, double> intervals;
+  std::lock_guard<std::mutex> lock(keepaliveTableMutex);
+  for (const auto& [key, learned] : keepaliveTable) {
+    if (learned.provenMs > 0) {
+      intervals[key] = learned.provenMs;
+    }
+  }
+  return intervals;
+}
+
+void HybridWebSocket::setKeepaliveIntervals(const std::unordered_map<std::string, double>& intervals) {
+  std::lock_guard<std::mutex> lock(keepaliveTableMutex);
+  for (const auto& [key, ms] : intervals) {
+    if (ms > 0) {
+      keepaliveTable[key].provenMs = ms;
+    }
+  }
+}
+
+std::pair<int, std::string> HybridWebSocket::closeStatus() const {
+  if (_closeTimedOut) {
+    return {LWS_CLOSE_STATUS_ABNORMAL_CLOSE, "Close handshake timed out"};
+  }
+  if (_pongTimedOut) {
+    return {LWS_CLOSE_STATUS_ABNORMAL_CLOSE, "No pong within " + std::to_string(_pongTimeoutMs.load()) + " ms"};
+  }
+  if (_peerCloseCode != 0) {
+    return {_peerCloseCode, _peerCloseReason};
+  }
+  if (_closeRequested) {
+    // lws consumes the peer's echo of our close frame without reporting it
+    return {_closeCode, _closeReason};
+  }
+  return {LWS_CLOSE_STATUS_ABNORMAL_CLOSE, "Connection closed abnormally"};
+}
+
+// ============================================================
+// Cleanup
+// ============================================================
+
+void HybridWebSocket::cleanup() {
+  // From here on, callbacks from the current link are stale
+  {
+    std::lock_guard<std::mutex> lock(_lifecycleMutex);
+    _generation.fetch_add(1, std::memory_order_acq_rel);
+    _state = State::CLOSED;
+  }
+
+  // Teardown runs on the loop; nothing here waits for it, so a loop busy
+  // in DNS or a TLS handshake cannot stall the caller
+  if (_loop) {
+    _loop->post([this, self = shared()]() {
+      settleConnect(std::make_exception_ptr(std::runtime_error("Connection aborted")));
+      if (_link) {
+        detach(*_link);
+        _link.reset();
+      }
+      _rxMessage.clear();
+    });
+  }
+  
+  {
+    std::lock_guard<std::mutex> lock(_sendMutex);
+    while (!_sendQueue.empty()) {
+      _sendQueue.pop();
+    }
+  }
+  failDrainWaiters();
+}
+
+bool HybridWebSocket::transition(const Link& link, State state) {
+  std::lock_guard<std::mutex> lock(_lifecycleMutex);
+  if (!isCurrent(link)) {
+    return false;
+  }
+  _state = state;
+  return true;
+}
+
+void HybridWebSocket::detach(Link& link) {
+  lws_sul_cancel(&link.connectTimer.sul);
+  lws_sul_cancel(&link.closeTimer.sul);
+  lws_sul_cancel(&link.reconnectTimer.sul);
+  lws_sul_cancel(&link.raceTimer.sul);
+  lws_sul_cancel(&link.parkTimer.sul);
+  lws_sul_cancel(&link.pongTimer.sul);
+  link.dnsPending = 0;
+  link.pending.clear();
+  for (auto& racer : std::exchange(link.racers, {})) {
+    releaseAttempt(link, racer.wsi);
+    lws_set_timeout(racer.wsi, PENDING_TIMEOUT_USER_OK, LWS_TO_KILL_ASYNC);
+  }
+  if (link.wsi) {
+    // Detach first so no further callbacks reach the instance,
+    // then let lws close the socket on its next pass
+    lws_set_opaque_user_data(link.wsi, nullptr);
+    lws_set_timeout(link.wsi, PENDING_TIMEOUT_USER_OK, LWS_TO_KILL_ASYNC);
+    link.wsi = nullptr;
+    link.loop->connectionClosed();
+  }
+}
+
+void HybridWebSocket::failDrainWaiters() {
+  std::vector<std::function<void(bool)>> waiters;
+  {
+    std::lock_guard<std::mutex> lock(_sendMutex);
+    waiters.swap(_drainWaiters);
+  }
+  for (auto& waiter : waiters) {
+    waiter(false);
+  }
+}
+
+// ============================================================
+// Native sinks
+// ============================================================
+
+void HybridWebSocket::registerNative(const std::string& name) {
+  if (name.empty()) {
+    throw std::invalid_argument("Native registry name must not be empty");
+  }
+  auto self = shared();
+
+  std::lock_guard<std::mutex> lock(_sinkMutex);
+  if (!_nativeName.empty() && _nativeName != name) {
+    NativeSocketRegistry::remove(_nativeName, this);
+  }
+  _nativeName = name;
+  NativeSocketRegistry::add(name, std::weak_ptr<NativeSocket>(self));
+}
+
+void HybridWebSocket::unregisterNative() {
+  std::lock_guard<std::mutex> lock(_sinkMutex);
+  if (!_nativeName.empty()) {
+    NativeSocketRegistry::remove(_nativeName, this);
+    _nativeName.clear();
+  }
+}
+
+void HybridWebSocket::addSink(const std::shared_ptr<NativeMessageSink>& sink) {
+  if (!sink) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(_sinkMutex);
+  auto next = _sinks ? std::make_shared<SinkList>(*_sinks) : std::make_shared<SinkList>();
+  if (std::find(next->begin(), next->end(), sink) == next->end()) {
+    next->push_back(sink);
+  }
+  _sinks = std::move(next);
+}
+
+void HybridWebSocket::removeSink(const std::shared_ptr<NativeMessageSink>& sink) {
+  std::lock_guard<std::mutex> lock(_sinkMutex);
+  if (!_sinks) {
+    return;
+  }
+  auto next = std::make_shared<SinkList>(*_sinks);
+  next->erase(std::remove(next->begin(), next->end(), sink), next->end());
+  _sinks = next->empty() ? nullptr : std::shared_ptr<const SinkList>(std::move(next));
+}
+
+std::shared_ptr<const HybridWebSocket::SinkList> HybridWebSocket::sinks() {
+  std::lock_guard<std::mutex> lock(_sinkMutex);
+  return _sinks;
+}
+
+bool HybridWebSocket::sendNative(const uint8_t* data, size_t len, bool isBinary) {
+  State state = _state.load();
+  if (state != State::OPEN && !(state == State::CONNECTING && _queueWhileConnecting)) {
+    return false;
+  }
+
+  QueuedMessage msg;
+  msg.data.assign(data, data + len);
+  msg.isBinary = isBinary;
+  enqueue(std::move(msg));
+  return true;
+}
+
+void HybridWebSocket::whenDrained(std::function<void(bool drained)> callback) {
+  State state = _state.load();
+  if (state != State::OPEN && state != State::CONNECTING) {
+    callback(false);
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(_sendMutex);
+    _drainWaiters.push_back(std::move(callback));
+  }
+  // Same handoff as enqueue(): ESTABLISHED flushes while CONNECTING
+  if (_state == State::OPEN) {
+    requestWrite();
+  }
+}
+
+// ============================================================
+// State Store
+// ============================================================
+
+void HybridWebSocket::enableStateStore(const std::string& patchFormat) {
+  auto store = std::make_shared<StateStore>(StateStore::parseFormat(patchFormat));
+  std::lock_guard<std::mutex> lock(_stateStoreMutex);
+  _stateStore = std::move(store);
+}
+
+void HybridWebSocket::disableStateStore() {
+  std::lock_guard<std::mutex> lock(_stateStoreMutex);
+  _stateStore.reset();
+}
+
+std::optional<std::string> HybridWebSocket::getStateSnapshot(const std::string& key) {
+  std::lock_guard<std::mutex> lock(_stateStoreMutex);
+  return _stateStore ? _stateStore->snapshot(key) : std::nullopt;
+}
+
+double HybridWebSocket::getStateVersion(const std::string& key) {
+  std::lock_guard<std::mutex> lock(_stateStoreMutex);
+  return _stateStore ? static_cast<double>(_stateStore->version(key)) : 0.0;
+}
+
+std::vector<std::string> HybridWebSocket::takeStateChanges(const std::string& key) {
+  std::lock_guard<std::mutex> lock(_stateStoreMutex);
+  return _stateStore ? _stateStore->takeChangedPaths(key) : std::vector<std::string>{};
+}
+
+// ============================================================
+// Receive Ring
+// ============================================================
+
+std::shared_ptr<ArrayBuffer> HybridWebSocket::enableReceiveRing(double capacityBytes) {
+  if (!(capacityBytes > 0 && capacityBytes <= UINT32_MAX)) {
+    throw std::invalid_argument("Receive ring capacity must be between 1 and 4294967295 bytes");
+  }
+  auto ring = std::make_shared<ReceiveRing>(static_cast<size_t>(capacityBytes));
+
+  {
+    std::lock_guard<std::mutex> lock(_receiveRingMutex);
+    _receiveRing = ring;
+  }
+
+  // The ArrayBuffer keeps the ring memory alive for as long as JS holds it
+  return ArrayBuffer::wrap(ring->data(), ring->size(), [ring]() {});
+}
+
+void HybridWebSocket::disableReceiveRing() {
+  std::lock_guard<std::mutex> lock(_receiveRingMutex);
+  _receiveRing.reset();
+}
+
+double HybridWebSocket::syncReceiveRing(double consumedTail) {
+  std::shared_ptr<ReceiveRing> ring;
+  {
+    std::lock_guard<std::mutex> lock(_receiveRingMutex);
+    ring = _receiveRing;
+  }
+  if (!ring) {
+    throw std::runtime_error("Receive ring is not enabled");
+  }
+  if (!(consumedTail >= 0 && consumedTail <= UINT32_MAX) || consumedTail != std::floor(consumedTail)) {
+    throw std::invalid_argument("Consumed tail must be an integer between 0 and 4294967295");
+  }
+  return static_cast<double>(ring->sync(static_cast<uint32_t>(consumedTail)));
+}
+
+// ============================================================
+// Channels
+// ============================================================
+
+std::shared_ptr<ChannelMux> HybridWebSocket::channelMux() {
+  std::shared_ptr<ChannelMux> mux;
+  {
+    std::lock_guard<std::mutex> lock(_channelMuxMutex);
+    if (_channelMux) {
+      return _channelMux;
+    }
+    mux = _channelMux = std::make_shared<ChannelMux>(shared());
+  }
+  addSink(mux);
+  return mux;
+}
+
+std::shared_ptr<ChannelMux> HybridWebSocket::existingChannelMux() {
+  std::lock_guard<std::mutex> lock(_channelMuxMutex);
+  return _channelMux;
+}
+
+uint16_t HybridWebSocket::channelId(double id) {
+  if (!(id >= 0 && id <= UINT16_MAX) || id != std::floor(id)) {
+    throw std::invalid_argument("Channel id must be an integer between 0 and 65535");
+  }
+  return static_cast<uint16_t>(id);
+}
+
+void HybridWebSocket::openChannel(
+    double id,
+    const std::function<void(const std::string&)>& onMessage,
+    const std::optional<std::function<void(const std::shared_ptr<ArrayBuffer>&)>>& onBinaryMessage,
+    std::optional<double> window) {
+  uint16_t channel = channelId(id);
+  uint32_t windowBytes = ChannelMux::INITIAL_WINDOW;
+  if (window.has_value()) {
+    if (!(window.value() >= ChannelMux::INITIAL_WINDOW && window.value() <= ChannelMux::MAX_WINDOW)) {
+      throw std::invalid_argument("Channel window must be between " + std::to_string(ChannelMux::INITIAL_WINDOW) +
+                                  " and " + std::to_string(ChannelMux::MAX_WINDOW) + " bytes");
+    }
+    windowBytes = static_cast<uint32_t>(window.value());
+  }
+
+  // Same delivery as onMessage / onBinaryMessage, per channel
+  channelMux()->open(channel, [onMessage, onBinaryMessage](const uint8_t* data, size_t len, bool isBinary) {
+    try {
+      if (!isBinary) {
+        onMessage(std::string(reinterpret_cast<const char*>(data), len));
+      } else if (onBinaryMessage.has_value()) {
+        onBinaryMessage.value()(ArrayBuffer::copy(data, len));
+      }
+    } catch (...) {
+      // Catch exceptions from JS callback
+    }
+  }, windowBytes);
+}
+
+void HybridWebSocket::closeChannel(double id) {
+  uint16_t channel = channelId(id);
+  if (auto mux = existingChannelMux()) {
+    mux->close(channel);
+  }
+}
+
+bool HybridWebSocket::sendChannel(double id, const std::string& message) {
+  uint16_t channel = channelId(id);
+  auto mux = existingChannelMux();
+  if (!mux) {
+    return false;
+  }
+  return mux->send(channel, reinterpret_cast<const uint8_t*>(message.data()), message.size(), false);
+}
+
+bool HybridWebSocket::sendChannelBinary(double id, const std::shared_ptr<ArrayBuffer>& data) {
+  if (!data) {
+    throw std::invalid_argument("ArrayBuffer is null");
+  }
+  uint16_t channel = channelId(id);
+  auto mux = existingChannelMux();
+  if (!mux) {
+    return false;
+  }
+  return mux->send(channel, data->data(), data->size(), true);
+}
+
+std::unordered_map<std::string, double> HybridWebSocket::getChannelStats(double id) {
+  uint16_t channel = channelId(id);
+  auto mux = existingChannelMux();
+  if (!mux) {
+    return {};
+  }
+  auto stats = mux->stats(channel);
+  if (!stats.has_value()) {
+    return {};
+  }
+  return {
+    {"messagesSent", static_cast<double>(stats->messagesSent)},
+    {"messagesReceived", static_cast<double>(stats->messagesReceived)},
+    {"queuedBytes", static_cast<double>(stats->queuedBytes)},
+    {"sendCredit", static_cast<double>(stats->sendCredit)},
+    {"creditWaits", static_cast<double>(stats->creditWaits)},
+    {"dropped", static_cast<double>(stats->dropped)},
+  };
+}
+
+// ============================================================
+// Event loop stats
+// ============================================================
+
+std::unordered_map<std::string, double> HybridWebSocket::getEventLoopStats() {
+  // Summed over the pool; zeros until the first connect() starts it
+  EventLoop::Stats stats = EventLoop::totalStats();
+  return {
+    {"loops", static_cast<double>(EventLoop::poolSize())},
+    {"servicePasses", static_cast<double>(stats.servicePasses)},
+    {"wakeups", static_cast<double>(stats.wakeups)},
+    {"tasks", static_cast<double>(stats.tasks)},
+  };
+}
+
+std::unordered_map<std::string, double> HybridWebSocket::getConnectStats() {
+  uint64_t tlsHandshakes = _tlsHandshakes.load(std::memory_order_relaxed);
+  uint64_t tlsResumed = _tlsResumed.load(std::memory_order_relaxed);
+  return {
+    {"connects", static_cast<double>(_connects.load(std::memory_order_relaxed))},
+    {"lastConnectMs", _lastConnectMs.load(std::memory_order_relaxed)},
+    {"tlsReused", _vhostReused.load(std::memory_order_relaxed) ? 1.0 : 0.0},
+    {"reconnects", static_cast<double>(_reconnects.load(std::memory_order_relaxed))},
+    {"tlsHandshakes", static_cast<double>(tlsHandshakes)},
+    {"tlsResumed", static_cast<double>(tlsResumed)},
+    {"warmAdopted", static_cast<double>(_warmAdopted.load(std::memory_order_relaxed))},
+    {"raceFallbacks", static_cast<double>(_raceFallbacks.load(std::memory_order_relaxed))},
+    {"tlsResumeRate", tlsHandshakes > 0 ? static_cast<double>(tlsResumed) / tlsHandshakes : 0.0},
+  };
+}
+
+std::unordered_map<std::string, double> HybridWebSocket::getEndpointLatencies() {
+  std::lock_guard<std::mutex> lock(latencyMutex);
+  return endpointLatencies;
+}
+
+void HybridWebSocket::setEndpointLatencies(const std::unordered_map<std::string, double>& latencies) {
+  std::lock_guard<std::mutex> lock(latencyMutex);
+  for (const auto& [url, ms] : latencies) {
+    if (ms > 0) {
+      endpointLatencies[url] = ms;
+    }
+  }
+}
+
+void HybridWebSocket::prefetchDns(const std::string& host) {
+  if (host.empty()) {
+    throw std::invalid_argument("prefetchDns() needs a host name");
+  }
+  DnsResolver::resolve(host, [host](const DnsResolver::Addresses& addresses) {
+    #ifdef DEBUG
+    printf("[WebSocket] DNS prefetch %s: %s\n", host.c_str(), addresses.empty() ? "failed" : "resolved");
+    #endif
+  });
+}
+
+void HybridWebSocket::configureEventLoops(double count, const std::string& assignment) {
+  EventLoop::configurePool(static_cast<size_t>(std::max(count, 0.0)), EventLoop::parseAssignment(assignment));
+}
+
+void HybridWebSocket::setServiceThreadOptions(const ServiceThreadOptions& options) {
+  EventLoop::ThreadOptions threadOptions;
+
+  if (options.name.has_value() && !options.name->empty()) {
+    threadOptions.name = options.name.value();
+  }
+
+  if (options.nice.has_value()) {
+    double nice = options.nice.value();
+    if (nice < -20 || nice > 19) {
+      throw std::invalid_argument("nice must be between -20 and 19");
+    }
+    threadOptions.nice = static_cast<int>(nice);
+  }
+
+  if (options.cpuAffinity.has_value()) {
+    for (double cpu : options.cpuAffinity.value()) {
+      if (!(cpu >= 0 && cpu < EventLoop::MAX_CPUS) || cpu != std::floor(cpu)) {
+        throw std::invalid_argument("CPU index must be an integer between 0 and " +
+                                    std::to_string(EventLoop::MAX_CPUS - 1));
+      }
+      threadOptions.cpus.push_back(static_cast<int>(cpu));
+    }
+  }
+
+  EventLoop::setThreadOptions(threadOptions);
+}
+
+// ============================================================
+// Getters / Setters
+// ============================================================
+
+void HybridWebSocket::setPingInterval(double intervalMs) {
+  _pingIntervalMs = static_cast<int>(intervalMs);
+  // Note: Actual ping sending is handled in the service loop
+  // We do NOT use lws_set_timeout here as that would close the connection
+}
+
+void HybridWebSocket::setPongTimeout(double timeoutMs) {
+  if (!(timeoutMs >= 0)) {
+    throw std::invalid_argument("Pong timeout must be 0 or a positive number of milliseconds");
+  }
+  // Applies from the next ping
+  _pongTimeoutMs = static_cast<int>(timeoutMs);
+}
+
+void HybridWebSocket::setCAPath(const std::string& path) {
+  _caPath = path;
+}
+
+void HybridWebSocket::setReceiveBufferSize(double bytes) {
+  if (_state != State::CLOSED) {
+    throw std::runtime_error("Receive buffer size must be set before connect()");
+  }
+  _rxBufferSize = std::clamp(static_cast<size_t>(bytes), MIN_RX_BUFFER_SIZE, MAX_RX_BUFFER_SIZE);
+}
+
+void HybridWebSocket::setQueueWhileConnecting(bool enabled) {
+  _queueWhileConnecting = enabled;
+}
+
+void HybridWebSocket::setMaxMessageSize(double bytes) {
+  _maxMessageSize = bytes > 0 ? static_cast<size_t>(bytes) : 0;
+}
+
+double HybridWebSocket::getState() {
+  return static_cast<double>(_state.load());
+}
+
+std::string HybridWebSocket::getUrl() {
+  std::lock_guard<std::mutex> lock(_lifecycleMutex);
+  return _url;
+}
+
+std::string HybridWebSocket::getEndpoint() {
+  std::lock_guard<std::mutex> lock(_lifecycleMutex);
+  return _endpointUrl;
+}
+
+void HybridWebSocket::setOnOpen(
+    const std::optional<std::function<void()>>& value) {
+  std::lock_guard<std::mutex> lock(_callbackMutex);
+  _onOpen = value;
+}
+
+void HybridWebSocket::setOnMessage(
+    const std::optional<std::function<void(const std::string&)>>& value) {
+  std::lock_guard<std::mutex> lock(_callbackMutex);
+  _onMessage = value;
+}
+
+void HybridWebSocket::setOnBinaryMessage(
+    const std::optional<std::function<void(const std::shared_ptr<ArrayBuffer>&)>>& value) {
+  std::lock_guard<std::mutex> lock(_callbackMutex);
+  _onBinaryMessage = value;
+}
+
+void HybridWebSocket::setOnMsgPackMessage(
+    const std::optional<std::function<void(const std::shared_ptr<AnyMap>&)>>& value) {
+  std::lock_guard<std::mutex> lock(_callbackMutex);
+  _onMsgPackMessage = value;
+}
+
+void HybridWebSocket::setOnCborMessage(
+    const std::optional<std::function<void(const std::shared_ptr<AnyMap>&)>>& value) {
+  std::lock_guard<std::mutex> lock(_callbackMutex);
+  _onCborMessage = value;
+}
+
+void HybridWebSocket::setOnError(
+    const std::optional<std::function<void(const std::string&)>>& value) {
+  std::lock_guard<std::mutex> lock(_callbackMutex);
+  _onError = value;
+}
+
+void HybridWebSocket::setOnClose(
+    const std::optional<std::function<void(double, const std::string&)>>& value) {
+  std::lock_guard<std::mutex> lock(_callbackMutex);
+  _onClose = value;
+}
+
+void HybridWebSocket::setOnReconnect(
+    const std::optional<std::function<void(double, double)>>& value) {
+  std::lock_guard<std::mutex> lock(_callbackMutex);
+  _onReconnect = value;
+}
+
+// ============================================================
+// Message dispatch (service thread)
+// ============================================================
+
+void HybridWebSocket::dispatchMessage(const uint8_t* data, size_t len, bool isBinary) {
+  // Track performance metrics
+  _messagesReceived.fetch_add(1, std::memory_order_relaxed);
+  _bytesReceived.fetch_add(len, std::memory_order_relaxed);
+
+  // Native sinks see every message first and may consume it
+  if (auto sinkList = sinks()) {
+    bool consumed = false;
+    for (const auto& sink : *sinkList) {
+      consumed = sink->onMessage(data, len, isBinary) || consumed;
+    }
+    if (consumed) {
+      return;
+    }
+  }
+
+  // Ring mode: append and return, no per-message dispatch
+  std::shared_ptr<ReceiveRing> ring;
+  {
+    std::lock_guard<std::mutex> ringLock(_receiveRingMutex);
+    ring = _receiveRing;
+  }
+
+  if (isBinary) {
+    if (ring) {
+      ring->write(data, len, true);
+      return;
+    }
+    dispatchBinary(data, len);
+  } else {
+    // State envelopes are applied natively and not forwarded to JS
+    std::shared_ptr<StateStore> store;
+    {
+      std::lock_guard<std::mutex> storeLock(_stateStoreMutex);
+      store = _stateStore;
+    }
+    if (store) {
+      std::string storeError;
+      if (store->consume(reinterpret_cast<const char*>(data), len, storeError)) {
+        if (!storeError.empty()) {
+          emitError(storeError);
+        }
+        return;
+      }
+    }
+
+    if (ring) {
+      ring->write(data, len, false);
+      return;
+    }
+
+    // Text message - reserve space for better performance
+    std::string message;
+    message.reserve(len);
+    message.assign(reinterpret_cast<const char*>(data), len);
+
+    // Optimize: check if callback exists before locking
+    std::unique_lock<std::mutex> lock(_callbackMutex, std::defer_lock);
+    if (lock.try_lock() && _onMessage.has_value()) {
+      try {
+        // Copy callback to minimize critical section
+        auto callback = _onMessage.value();
+        lock.unlock();
+        // Execute outside of lock
+        callback(message);
+      } catch (...) {
+        // Catch exceptions from JS callback
+      }
+    }
+  }
+}
+
+int HybridWebSocket::rejectOversizedMessage(struct lws* wsi, size_t size) {
+  std::string error = "Message of " + std::to_string(size) +
+                      " bytes exceeds max message size of " +
+                      std::to_string(_maxMessageSize) + " bytes";
+  emitError(error);
+
+  // Close with 1009 (Message Too Big); returning -1 makes lws send the close frame
+  lws_close_reason(
+    wsi,
+    LWS_CLOSE_STATUS_MESSAGE_TOO_LARGE,
+    reinterpret_cast<unsigned char*>(error.data()),
+    std::min(error.size(), static_cast<size_t>(123))
+  );
+  return -1;
+}
+
+void HybridWebSocket::emitError(const std::string& error) {
+  std::lock_guard<std::mutex> lock(_callbackMutex);
+  if (_onError.has_value()) {
+    try {
+      _onError.value()(error);
+    } catch (...) {}
+  }
+}
+
+// ============================================================
+// Binary dispatch (service thread)
+// ============================================================
+
+void HybridWebSocket::dispatchBinary(const uint8_t* data, size_t len) {
+  std::unique_lock<std::mutex> lock(_callbackMutex);
+
+  // Codec callbacks take precedence over raw ArrayBuffer delivery
+  std::optional<std::function<void(const std::shared_ptr<AnyMap>&)>> decodedCallback;
+  Codec codec = Codec::NONE;
+  if (_onMsgPackMessage.has_value()) {
+    decodedCallback = _onMsgPackMessage;
+    codec = Codec::MSGPACK;
+  } else if (_onCborMessage.has_value()) {
+    decodedCallback = _onCborMessage;
+    codec = Codec::CBOR;
+  }
+  auto binaryCallback = _onBinaryMessage;
+  auto errorCallback = _onError;
+  lock.unlock();
+
+  if (decodedCallback.has_value()) {
+    std::shared_ptr<AnyMap> value;
+    try {
+      value = codec == Codec::MSGPACK ?
+              BinaryCodec::decodeMsgPack(data, len) :
+              BinaryCodec::decodeCbor(data, len);
+    } catch (const std::exception& e) {
+      if (errorCallback.has_value()) {
+        try {
+          errorCallback.value()(std::string("Failed to decode message: ") + e.what());
+        } catch (...) {}
+      }
+    }
+
+    if (value) {
+      try {
+        decodedCallback.value()(value);
+      } catch (...) {
+        // Catch exceptions from JS callback
+      }
+      return;
+    }
+  }
+
+  // Raw delivery (or fallback for frames that failed to decode)
+  if (binaryCallback.has_value()) {
+    try {
+      binaryCallback.value()(ArrayBuffer::copy(data, len));
+    } catch (...) {
+      // Catch exceptions from JS callback
+    }
+  }
+}
+
+// ============================================================
+// Established (loop thread)
+// ============================================================
+
+int HybridWebSocket::onEstablished(Link& link, struct lws* wsi) {
+  bool closing;
+  {
+    std::lock_guard<std::mutex> lock(_lifecycleMutex);
+    // close() while waiting on DNS already settled this connection
+    if (!isCurrent(link) || _state == State::CLOSED) {
+      return -1;
+    }
+    // Connection established, unless close() ran during the handshake
+    closing = _state == State::CLOSING;
+    if (!closing) {
+      _state = State::OPEN;
+    }
+  }
+  // First attempt through the handshake wins the race
+  finishRace(link, wsi);
+
+  // close() during the handshake: close as soon as we are connected
+  if (closing) {
+    settleConnect(std::make_exception_ptr(
+      std::runtime_error("Connection closed before the handshake completed")));
+    return -1;
+  }
+  settleConnect(nullptr);
+  link.openedAt = std::chrono::steady_clock::now();
+
+  auto elapsed = std::chrono::steady_clock::now() - _connectStarted;
+  _lastConnectMs = std::chrono::duration<double, std::milli>(elapsed).count();
+  _connects.fetch_add(1, std::memory_order_relaxed);
+  if (_endpoints[link.endpoint].useSsl) {
+    _tlsHandshakes.fetch_add(1, std::memory_order_relaxed);
+#if defined(LWS_WITH_TLS_SESSIONS)
+    if (lws_tls_session_is_reused(wsi)) {
+      _tlsResumed.fetch_add(1, std::memory_order_relaxed);
+    }
+#endif
+  }
+
+  // Flush messages queued while CONNECTING in this same pass, so the
+  // first frames go out without waiting for a JS round trip via onOpen.
+  // Open messages (auth, subscriptions) go first
+  queueOpenMessages(link);
+  if (flushSendQueue(link, wsi) < 0) {
+    return -1;
+  }
+
+  if (_parked) {
+    // Preconnected: wait for connect() to adopt it, up to WARM_TTL_MS
+    lws_sul_schedule(_loop->context(), 0, &link.parkTimer.sul,
+                     HybridWebSocket::onParkTimeout,
+                     static_cast<lws_usec_t>(WARM_TTL_MS) * LWS_US_PER_MS);
+  }
+
+  startKeepalive(link, wsi);
+
+  #ifdef DEBUG
+  printf("[WebSocket] Connection established successfully!\n");
+  #endif
+
+  if (auto sinkList = sinks()) {
+    for (const auto& sink : *sinkList) {
+      sink->onOpen();
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(_callbackMutex);
+  if (_onOpen.has_value()) {
+    try {
+      _onOpen.value()();
+    } catch (...) {
+      // Catch exceptions from JS callback
+    }
+  }
+  return 0;
+}
+
+// ============================================================
+// LibWebSockets Callback Handler
+// ============================================================
+
+int HybridWebSocket::websocketCallback(
+    struct lws* wsi,
+    enum lws_callback_reasons reason,
+    void* user,
+    void* in,
     size_t len) {
   
-  auto* userData = static_cast<WebSocketUserData*>(user);
-  if (!userData || !userData->instance) {
+  // Null for detached connections and for vhost-wide events
+  auto* link = wsi ? static_cast<Link*>(lws_get_opaque_user_data(wsi)) : nullptr;
+  if (!link) {
     return 0;
   }
-  
-  auto* ws = userData->instance;
-  
-  switch (reason) {
-    case LWS_CALLBACK_CLIENT_ESTABLISHED: {
-      // Connection established
-      ws->_state = State::OPEN;
 
-      if (ws->_pingIntervalMs > 0) {
-        lws_set_timer_usecs(
-          wsi,
-          ws->_pingIntervalMs * 1000
-        );
-      }
+  // Connection accounting holds even if the owner is gone or superseded
+  if (reason == LWS_CALLBACK_WSI_DESTROY) {
+    auto racer = std::find_if(link->racers.begin(), link->racers.end(),
+                              [wsi](const Link::Attempt& attempt) { return attempt.wsi == wsi; });
+    if (link->wsi == wsi) {
+      link->wsi = nullptr;
+      link->loop->connectionClosed();
+    } else if (racer != link->racers.end()) {
+      link->racers.erase(racer);
+      link->loop->connectionClosed();
+    }
+  }
 
-      #ifdef DEBUG
-      printf("[WebSocket] Connection established successfully!\n");
-      #endif
+  // Strong reference for the rest of the callback. Null once the instance
+  // was released (its destructor queued the detach); stale links are
+  // ignored until cleanup()'s detach task runs
+  auto self = link->owner.lock();
+  if (!self || !self->isCurrent(*link)) {
+    return 0;
+  }
+  auto* ws = self.get();
+  
+  switch (reason) {
+    case LWS_CALLBACK_CONNECTING: {
+      // Socket created, connect() not called yet: every attempt (race
+      // attempts and reconnects included) gets the same tuning
+      auto fd = static_cast<lws_sockfd_type>(reinterpret_cast<intptr_t>(in));
+      applySocketTuning(ws->_socketTuning, fd);
+      break;
+    }
 
-      std::lock_guard<std::mutex> lock(ws->_callbackMutex);
-      if (ws->_onOpen.has_value()) {
-        try {
-          ws->_onOpen.value()();
-        } catch (...) {
-          // Catch exceptions from JS callback
-        }
+    case LWS_CALLBACK_CLIENT_ESTABLISHED: {
+      if (ws->onEstablished(*link, wsi) < 0) {
+        return -1;
       }
       break;
     }
       
     case LWS_CALLBACK_CLIENT_RECEIVE: {
-      bool isBinary = lws_frame_is_binary(wsi);
-
-      // Track performance metrics
-      ws->_messagesReceived.fetch_add(1, std::memory_order_relaxed);
-      ws->_bytesReceived.fetch_add(len, std::memory_order_relaxed);
-
-      if (isBinary) {
-        // Binary message - use static factory method
-        auto buffer = ArrayBuffer::copy(static_cast<const uint8_t*>(in), len);
-
-        // Optimize: check if callback exists before locking
-        std::unique_lock<std::mutex> lock(ws->_callbackMutex, std::defer_lock);
-        if (lock.try_lock() && ws->_onBinaryMessage.has_value()) {
-          try {
-            // Copy callback to minimize critical section
-            auto callback = ws->_onBinaryMessage.value();
-            lock.unlock();
-            // Execute outside of lock
-            callback(buffer);
-          } catch (...) {
-            // Catch exceptions from JS callback
-          }
+      link->lastRxAt = std::chrono::steady_clock::now();
+      link->lastDataAt = link->lastRxAt;
+      auto* data = static_cast<const uint8_t*>(in);
+      bool first = lws_is_first_fragment(wsi);
+      bool final = lws_is_final_fragment(wsi);
+
+      // Fast path: whole message in one callback, deliver without copying
+      if (first && final && ws->_rxMessage.empty()) {
+        if (ws->_maxMessageSize > 0 && len > ws->_maxMessageSize) {
+          return ws->rejectOversizedMessage(wsi, len);
         }
-      } else {
-        // Text message - reserve space for better performance
-        std::string message;
-        message.reserve(len);
-        message.assign(static_cast<char*>(in), len);
-
-        // Optimize: check if callback exists before locking
-        std::unique_lock<std::mutex> lock(ws->_callbackMutex, std::defer_lock);
-        if (lock.try_lock() && ws->_onMessage.has_value()) {
-          try {
-            // Copy callback to minimize critical section
-            auto callback = ws->_onMessage.value();
-            lock.unlock();
-            // Execute outside of lock
-            callback(message);
-          } catch (...) {
-            // Catch exceptions from JS callback
-          }
+        ws->dispatchMessage(data, len, lws_frame_is_binary(wsi));
+        break;
+      }
+
+      // Reassemble messages that span frames or exceed rx_buffer_size
+      if (first) {
+        ws->_rxMessage.clear();
+        ws->_rxIsBinary = lws_frame_is_binary(wsi);
+      }
+      size_t total = ws->_rxMessage.size() + len;
+      if (ws->_maxMessageSize > 0 && total > ws->_maxMessageSize) {
+        ws->_rxMessage.clear();
+        return ws->rejectOversizedMessage(wsi, total);
+      }
+      ws->_rxMessage.insert(ws->_rxMessage.end(), data, data + len);
+
+      if (final) {
+        ws->dispatchMessage(ws->_rxMessage.data(), ws->_rxMessage.size(), ws->_rxIsBinary);
+        ws->_rxMessage.clear();
+        // Don't let one huge message pin its buffer for the connection's lifetime
+        if (ws->_rxMessage.capacity() > ws->_rxBufferSize * 4) {
+          ws->_rxMessage.shrink_to_fit();
         }
       }
       break;
     }
       
     case LWS_CALLBACK_CLIENT_CONNECTION_ERROR: {
+      // One attempt of a race failed; the other carries on
+      if (ws->dropAttempt(*link, wsi)) {
+        #ifdef DEBUG
+        printf("[WebSocket] Connection attempt failed, continuing with the other address\n");
+        #endif
+        break;
+      }
       // Connection error
-      ws->_state = State::CLOSED;
+      if (!ws->transition(*link, State::CLOSED)) {
+        break;
+      }
 
       std::string error = in ?
         std::string(static_cast<char*>(in)) :
@@ -614,79 +2702,137 @@ int HybridWebSocket::websocketCallback(
       printf("[WebSocket] CONNECTION ERROR: %s\n", error.c_str());
       printf("[WebSocket] URL was: %s\n", ws->_url.c_str());
 
-      std::lock_guard<std::mutex> lock(ws->_callbackMutex);
-      if (ws->_onError.has_value()) {
-        try {
-          ws->_onError.value()(error);
-        } catch (...) {}
+      ws->settleConnect(std::make_exception_ptr(std::runtime_error(error)));
+      ws->failDrainWaiters();
+
+      // 1006: closed abnormally, no close frame
+      if (auto sinkList = ws->sinks()) {
+        for (const auto& sink : *sinkList) {
+          sink->onClose(1006, error);
+        }
+      }
+
+      {
+        std::lock_guard<std::mutex> lock(ws->_callbackMutex);
+        if (ws->_onError.has_value()) {
+          try {
+            ws->_onError.value()(error);
+          } catch (...) {}
+        }
       }
+      ws->scheduleReconnect(*link);
       break;
     }
       
     case LWS_CALLBACK_CLIENT_CLOSED: {
       // Connection closed
-      ws->_state = State::CLOSED;
+      if (!ws->transition(*link, State::CLOSED)) {
+        break;
+      }
+      ws->failDrainWaiters();
+      lws_sul_cancel(&link->closeTimer.sul);
+      lws_sul_cancel(&link->pongTimer.sul);
+      ws->keepaliveClosed(*link);
+
+      auto [code, closeReason] = ws->closeStatus();
+      if (auto sinkList = ws->sinks()) {
+        for (const auto& sink : *sinkList) {
+          sink->onClose(code, closeReason);
+        }
+      }
       
-      std::lock_guard<std::mutex> lock(ws->_callbackMutex);
-      if (ws->_onClose.has_value()) {
-        try {
-          ws->_onClose.value()(1000.0, "Connection closed");
-        } catch (...) {}
+      {
+        std::lock_guard<std::mutex> lock(ws->_callbackMutex);
+        if (ws->_onClose.has_value()) {
+          try {
+            ws->_onClose.value()(static_cast<double>(code), closeReason);
+          } catch (...) {}
+        }
       }
+      ws->scheduleReconnect(*link);
       break;
     }
       
     case LWS_CALLBACK_CLIENT_WRITEABLE: {
+      if (ws->_closeRequested) {
+        return ws->continueClose(*link, wsi);
+      }
+
       // Send ping only if timer triggered it (atomic exchange clears flag)
       if (ws->_pingPending.exchange(false, std::memory_order_relaxed)) {
-        // Send ping frame with empty payload
-        unsigned char ping_payload[LWS_PRE];
-        lws_write(wsi, &ping_payload[LWS_PRE], 0, LWS_WRITE_PING);
-
-        #ifdef DEBUG
-        printf("[WebSocket] Ping sent (interval: %dms)\n", ws->_pingIntervalMs);
-        #endif
+        if (ws->sendPing(*link, wsi) < 0) {
+          return -1;
+        }
       }
       // Ready to write more data
-      break;
+      return ws->flushSendQueue(*link, wsi);
     }
 
     case LWS_CALLBACK_WS_PEER_INITIATED_CLOSE: {
-      // Server initiated close
+      // Server initiated close; lws echoes it. Payload: u16 code (big-endian) + reason
+      auto* payload = static_cast<const uint8_t*>(in);
+      if (payload && len >= 2) {
+        ws->_peerCloseCode = (payload[0] << 8) | payload[1];
+        ws->_peerCloseReason.assign(reinterpret_cast<const char*>(payload + 2), len - 2);
+      } else {
+        ws->_peerCloseCode = LWS_CLOSE_STATUS_NO_STATUS;
+      }
       #ifdef DEBUG
-      printf("[WebSocket] Server initiated close\n");
+      printf("[WebSocket] Server initiated close (%d)\n", ws->_peerCloseCode);
       #endif
       break;
     }
 
     case LWS_CALLBACK_CLIENT_RECEIVE_PONG: {
-      // Received pong response (libwebsockets handles this automatically)
-      #ifdef DEBUG
-      printf("[WebSocket] Received pong\n");
-      #endif
+      // Payload echoes our ping's sequence number
+      ws->onPong(*link, static_cast<const uint8_t*>(in), len);
+      break;
+    }
+
+    case LWS_CALLBACK_CLIENT_APPEND_HANDSHAKE_HEADER: {
+      // `in` points at the write cursor into the handshake buffer
+      auto** p = static_cast<unsigned char**>(in);
+      unsigned char* end = *p + len;
+      for (const auto& [name, value] : ws->_handshakeHeaders) {
+        std::string field = name + ":";
+        if (lws_add_http_header_by_name(
+              wsi,
+              reinterpret_cast<const unsigned char*>(field.c_str()),
+              reinterpret_cast<const unsigned char*>(value.data()),
+              static_cast<int>(value.size()),
+              p,
+              end)) {
+          printf("[WebSocket] Handshake headers exceed the lws buffer\n");
+          return -1;
+        }
+      }
       break;
     }
 
     case LWS_CALLBACK_WSI_DESTROY: {
-      // Connection being destroyed
-      if (userData) {
-        delete userData;
+      // Connection being destroyed (accounted for above). Settles a connect
+      // that ended without ESTABLISHED or CONNECTION_ERROR, e.g. close()
+      // mid-handshake. A race attempt going away leaves the others running
+      if (link->wsi || !link->racers.empty() || !link->pending.empty()) {
+        break;
       }
+      ws->settleConnect(std::make_exception_ptr(std::runtime_error("Connection closed")));
       break;
     }
 
     case LWS_CALLBACK_TIMER: {
-      if (ws->_state == State::OPEN && ws->_pingIntervalMs > 0) {
+      int intervalMs = ws->pingIntervalMs();
+      if (ws->_state == State::OPEN && intervalMs > 0) {
         // Mark that a ping is pending
         ws->_pingPending.store(true, std::memory_order_relaxed);
 
         // Request callback when socket is writable
         lws_callback_on_writable(wsi);
 
-        // Reschedule timer for next ping
+        // Reschedule timer for next ping (adaptive intervals change here)
         lws_set_timer_usecs(
           wsi,
-          ws->_pingIntervalMs * 1000
+          static_cast<lws_usec_t>(intervalMs) * LWS_US_PER_MS
         );
       }
       break;
@@ -2,6 +2,12 @@
 
 // IMPORTANT: Include the generated spec
 #include "HybridWebSocketSpec.hpp"
+#include "StateStore.hpp"
+#include "ReceiveRing.hpp"
+#include "ChannelMux.hpp"
+#include "DnsResolver.hpp"
+#include "EventLoop.hpp"
+#include "NativeSocket.hpp"
 
 #include <memory>
 #include <string>
@@ -11,6 +17,9 @@
 #include <mutex>
 #include <atomic>
 #include <queue>
+#include <deque>
+#include <unordered_map>
+#include <chrono>
 
 #include <libwebsockets.h>
 
@@ -35,11 +44,17 @@ enum class State {
  * by Nitrogen from WebSocket.nitro.ts
  * 
  * Thread Safety:
- * - All public methods are thread-safe
+ * - All public methods are thread-safe and never wait for the I/O thread
  * - Internal state protected by mutexes
- * - Service thread for I/O operations
+ * - All lws calls run on the shared EventLoop thread; loop tasks hold a
+ *   strong reference, lws callbacks a weak one (see Link), so the instance
+ *   can be released on any thread while its connection is torn down on
+ *   the loop
+ *
+ * Also implements NativeSocket so other native modules can exchange
+ * frames with the socket without going through JS.
  */
-class HybridWebSocket : public HybridWebSocketSpec {
+class HybridWebSocket : public HybridWebSocketSpec, public NativeSocket {
 public:
   /**
    * Constructor
@@ -65,11 +80,14 @@ public:
    * 
    * @param url WebSocket URL (ws:// or wss://)
    * @param protocols Optional sub-protocols
-   * @return Promise that resolves when connected
+   * @param options Handshake headers, sub-protocols and connect timeout
+   * @return Promise that resolves on handshake completion and rejects on
+   *         connection error, timeout or when the attempt is superseded
    */
   std::shared_ptr<Promise<void>> connect(
     const std::string& url, 
-    const std::optional<std::vector<std::string>>& protocols
+    const std::optional<std::vector<std::string>>& protocols,
+    const std::optional<WebSocketOptions>& options
   ) override;
   
   /**
@@ -83,42 +101,184 @@ public:
    * @throws std::runtime_error if not connected
    */
   void sendBinary(const std::shared_ptr<ArrayBuffer>& data) override;
+
+  /**
+   * Send object as MessagePack (encoded on the I/O thread)
+   * @throws std::runtime_error if not connected
+   */
+  void sendMsgPack(const std::shared_ptr<AnyMap>& value) override;
+
+  /**
+   * Send object as CBOR (encoded on the I/O thread)
+   * @throws std::runtime_error if not connected
+   */
+  void sendCbor(const std::shared_ptr<AnyMap>& value) override;
   
   /**
    * Close WebSocket connection
+   * Drains queued sends (if enabled), sends the close frame and waits for
+   * the peer's reply up to the close deadline
    */
   void close(
     const std::optional<double> code, 
     const std::optional<std::string>& reason
   ) override;
+
+  /**
+   * Set drain and deadline for subsequent close() calls
+   * @throws std::invalid_argument if timeout is not positive
+   */
+  void setCloseOptions(const CloseOptions& options) override;
+
+  /**
+   * Enable (or disable with nullopt) native reconnect with backoff
+   * @throws std::invalid_argument for out-of-range values
+   */
+  void setReconnectPolicy(const std::optional<ReconnectPolicy>& policy) override;
+
+  /**
+   * Messages replayed natively after every handshake
+   */
+  void setOpenMessages(const std::vector<std::string>& messages) override;
   
   /**
    * Set ping interval for keep-alive
    */
   void setPingInterval(double intervalMs) override;
 
+  /**
+   * Drop the connection when a ping gets no pong within `timeoutMs`
+   */
+  void setPongTimeout(double timeoutMs) override;
+
+  // Ping round trips: counters and rolling min / avg / p99 RTT
+  std::unordered_map<std::string, double> getPingStats() override;
+
+  /**
+   * Learn the ping interval per network and endpoint (nullopt = fixed)
+   * @throws std::invalid_argument for invalid bounds
+   */
+  void setAdaptiveKeepalive(const std::optional<KeepalivePolicy>& policy) override;
+
+  // Learned ping intervals (process-wide)
+  std::unordered_map<std::string, double> getKeepaliveIntervals() override;
+  void setKeepaliveIntervals(const std::unordered_map<std::string, double>& intervals) override;
+
   /**
    * Set CA certificate path for SSL verification
    */
   void setCAPath(const std::string& path) override;
 
+  /**
+   * Set receive buffer size (bytes read per lws callback) for this connection
+   * Applies to the next connect()
+   */
+  void setReceiveBufferSize(double bytes) override;
+
+  /**
+   * Set max reassembled message size (0 = unlimited)
+   */
+  void setMaxMessageSize(double bytes) override;
+
+  /**
+   * Accept sends while CONNECTING (flushed when the handshake completes)
+   */
+  void setQueueWhileConnecting(bool enabled) override;
+
+  // State store (JSON snapshot + patch documents)
+  void enableStateStore(const std::string& patchFormat) override;
+  void disableStateStore() override;
+  std::optional<std::string> getStateSnapshot(const std::string& key) override;
+  double getStateVersion(const std::string& key) override;
+  std::vector<std::string> takeStateChanges(const std::string& key) override;
+
+  // Receive ring (shared-memory consumer mode)
+  std::shared_ptr<ArrayBuffer> enableReceiveRing(double capacityBytes) override;
+  void disableReceiveRing() override;
+  double syncReceiveRing(double consumedTail) override;
+
+  // Logical channels (ChannelMux over this socket)
+  void openChannel(
+    double id,
+    const std::function<void(const std::string&)>& onMessage,
+    const std::optional<std::function<void(const std::shared_ptr<ArrayBuffer>&)>>& onBinaryMessage,
+    std::optional<double> window
+  ) override;
+  void closeChannel(double id) override;
+  bool sendChannel(double id, const std::string& message) override;
+  bool sendChannelBinary(double id, const std::shared_ptr<ArrayBuffer>& data) override;
+  std::unordered_map<std::string, double> getChannelStats(double id) override;
+
+  // Shared event loop pool
+  std::unordered_map<std::string, double> getEventLoopStats() override;
+
+  /**
+   * Set the number of event loops and how connections are assigned
+   * @throws std::invalid_argument for bad counts or assignment names
+   * @throws std::runtime_error to resize once the pool has started
+   */
+  void configureEventLoops(double count, const std::string& assignment) override;
+
+  // Connect latency and TLS state reuse for this instance
+  std::unordered_map<std::string, double> getConnectStats() override;
+
+  // Warm the loops' DNS cache for `host` (process-wide)
+  void prefetchDns(const std::string& host) override;
+
+  /**
+   * Open a connection to `url` ahead of use and park it for connect()
+   * @throws std::invalid_argument for an invalid URL or options
+   */
+  void preconnect(const std::string& url, const std::optional<WebSocketOptions>& options) override;
+
+  // Remembered handshake times per endpoint URL (process-wide)
+  std::unordered_map<std::string, double> getEndpointLatencies() override;
+  void setEndpointLatencies(const std::unordered_map<std::string, double>& latencies) override;
+
+  /**
+   * Configure the shared I/O thread (process-wide)
+   * @throws std::invalid_argument for out-of-range nice values or CPU indices
+   */
+  void setServiceThreadOptions(const ServiceThreadOptions& options) override;
+
+  // Native registry (see NativeSocket.hpp)
+  void registerNative(const std::string& name) override;
+  void unregisterNative() override;
+
+  // ============================================================
+  // NativeSocket Implementation
+  // ============================================================
+
+  void addSink(const std::shared_ptr<NativeMessageSink>& sink) override;
+  void removeSink(const std::shared_ptr<NativeMessageSink>& sink) override;
+  bool sendNative(const uint8_t* data, size_t len, bool isBinary) override;
+  void whenDrained(std::function<void(bool drained)> callback) override;
+  bool isOpen() const override { return _state == State::OPEN; }
+
   // Getters
   double getState() override;
   std::string getUrl() override;
+  std::string getEndpoint() override;
   
   // Callback setters
   void setOnOpen(const std::optional<std::function<void()>>& value) override;
   void setOnMessage(const std::optional<std::function<void(const std::string&)>>& value) override;
   void setOnBinaryMessage(const std::optional<std::function<void(const std::shared_ptr<ArrayBuffer>&)>>& value) override;
+  void setOnMsgPackMessage(const std::optional<std::function<void(const std::shared_ptr<AnyMap>&)>>& value) override;
+  void setOnCborMessage(const std::optional<std::function<void(const std::shared_ptr<AnyMap>&)>>& value) override;
   void setOnError(const std::optional<std::function<void(const std::string&)>>& value) override;
   void setOnClose(const std::optional<std::function<void(double, const std::string&)>>& value) override;
+  void setOnReconnect(const std::optional<std::function<void(double, double)>>& value) override;
   
   // Callback getters (required by spec)
   std::optional<std::function<void()>> getOnOpen() override { return _onOpen; }
   std::optional<std::function<void(const std::string&)>> getOnMessage() override { return _onMessage; }
   std::optional<std::function<void(const std::shared_ptr<ArrayBuffer>&)>> getOnBinaryMessage() override { return _onBinaryMessage; }
+  std::optional<std::function<void(const std::shared_ptr<AnyMap>&)>> getOnMsgPackMessage() override { return _onMsgPackMessage; }
+  std::optional<std::function<void(const std::shared_ptr<AnyMap>&)>> getOnCborMessage() override { return _onCborMessage; }
   std::optional<std::function<void(const std::string&)>> getOnError() override { return _onError; }
   std::optional<std::function<void(double, const std::string&)>> getOnClose() override { return _onClose; }
+  std::optional<std::function<void(double, double)>> getOnReconnect() override { return _onReconnect; }
 
   /**
    * Get external memory size for garbage collector
@@ -134,38 +294,162 @@ private:
   // LibWebSockets members
   // ============================================================
   
-  struct lws_context* _context = nullptr;
-  struct lws* _wsi = nullptr;
+  EventLoop* _loop = nullptr;  // set on first connect()
+
+  /**
+   * Loop-side handle for one connection attempt, set as the wsi's opaque
+   * user data. Callbacks reach the instance only through `owner.lock()`,
+   * and `generation` tells them whether cleanup() has superseded the
+   * attempt. Released on the loop thread after the wsi is detached.
+   */
+  struct Link {
+    struct Timer {
+      lws_sorted_usec_list_t sul;  // first member: the lws callback casts back from it
+      Link* link = nullptr;
+    };
+    Timer connectTimer{};
+    Timer closeTimer{};
+    Timer reconnectTimer{};
+    Timer raceTimer{};  // starts the delayed Happy Eyeballs attempt
+    Timer parkTimer{};  // expires an unadopted preconnect
+    Timer pongTimer{};  // pong deadline for the oldest unanswered ping
+    std::weak_ptr<HybridWebSocket> owner;
+    EventLoop* loop = nullptr;
+    uint64_t generation = 0;
+    struct lws_vhost* vhost = nullptr;
+    struct lws* wsi = nullptr;  // null once detached or destroyed
+    std::chrono::steady_clock::time_point openedAt{};  // epoch = never opened
+
+    // Pings carry an 8-byte sequence number; the pong for the latest one
+    // gives an RTT sample
+    uint64_t pingSeq = 0;
+    uint64_t awaitedSeq = 0;  // 0 = latest ping answered
+    std::chrono::steady_clock::time_point pingSentAt{};
+    bool pongDeadlineArmed = false;
+    std::chrono::steady_clock::time_point lastRxAt{};  // data or pong
+    // Keep-alive: a pong only proves the interval if nothing but the ping
+    // crossed the connection for the whole interval before it
+    std::chrono::steady_clock::time_point lastDataAt{};  // data sent or received
+    std::chrono::steady_clock::time_point quietSince{};  // keep-alive start or latest ping
+    bool pingIdle = false;  // latest ping followed a whole idle interval
+
+    // Connection attempts. `wsi` is the first one in flight and `racers`
+    // the others; the first through the handshake becomes `wsi` and the
+    // rest are dropped (see finishRace). Attempts waiting in `pending`
+    // start one per `raceDelayMs`, or as soon as everything in flight failed
+    struct Attempt {
+      struct lws* wsi;
+      size_t endpoint;  // index into _endpoints
+      std::chrono::steady_clock::time_point started;
+    };
+    struct Target {
+      std::string address;  // host name or IP literal
+      size_t endpoint;
+    };
+    size_t endpoint = 0;  // of `wsi`
+    std::chrono::steady_clock::time_point started{};  // of `wsi`
+    std::vector<Attempt> racers;
+    std::deque<Target> pending;
+    int raceDelayMs = 0;  // 0 = start all pending attempts at once
+
+    // Host name lookups (see resolveEndpoints); attempts start once every
+    // endpoint has an answer
+    std::unordered_map<std::string, DnsResolver::Addresses> resolved;
+    int dnsPending = 0;  // detach() zeroes it to drop late answers
+  };
+
+  struct Endpoint {
+    std::string url;
+    std::string host;
+    std::string path;
+    int port = 0;
+    bool useSsl = false;
+  };
+
+  enum class EndpointStrategy {
+    PRIORITY,  // in order, next one after failoverDelay or a failure
+    LATENCY,   // like PRIORITY, ordered by remembered handshake time
+    RACE       // all at once
+  };
+
+  /**
+   * Parse a strategy name ("priority", "latency" or "race")
+   * @throws std::invalid_argument for unknown names
+   */
+  static EndpointStrategy parseEndpointStrategy(const std::string& name);
+
+  // Resolved WebSocketOptions.socket; 0 = leave the OS default
+  struct SocketTuning {
+    bool noDelay = true;
+    int sendBufferSize = 0;
+    int receiveBufferSize = 0;
+    std::optional<bool> keepAlive;
+    int keepAliveIdleS = 0;
+    int keepAliveIntervalS = 0;
+    int keepAliveCount = 0;
+    int userTimeoutMs = 0;
+
+    // Distinguishes warm sockets dialed with different tuning
+    std::string key() const;
+  };
+
+  /**
+   * Validate and resolve socket options
+   * @throws std::invalid_argument for out-of-range values
+   */
+  static SocketTuning parseSocketOptions(const std::optional<SocketOptions>& options);
+
+  /**
+   * Apply `tuning` to a client socket before it connects (loop thread).
+   * Failures are logged; the connection goes ahead with OS defaults
+   */
+  static void applySocketTuning(const SocketTuning& tuning, lws_sockfd_type fd);
+
+  std::shared_ptr<Link> _link;  // loop thread only
+
+  // Bumped by cleanup(); callbacks from older links are ignored
+  std::atomic<uint64_t> _generation{0};
+  // Orders generation bumps with callback-side state transitions
+  std::mutex _lifecycleMutex;
   
   // ============================================================
   // Connection state
   // ============================================================
   
   std::atomic<State> _state{State::CLOSED};
+  // URL of the current connect(); written on the loop thread under
+  // _lifecycleMutex, so loop-thread reads need no lock
   std::string _url;
-  std::string _host;
-  std::string _path;
-  int _port = 0;
-  bool _useSsl = false;
   
   // ============================================================
   // Message queue (thread-safe)
   // ============================================================
 
+  enum class Codec {
+    NONE,
+    MSGPACK,
+    CBOR
+  };
+
   struct QueuedMessage {
     std::vector<uint8_t> data;
     bool isBinary;
+    // Objects queued by sendMsgPack/sendCbor are encoded on the I/O thread
+    std::shared_ptr<AnyMap> value;
+    Codec codec = Codec::NONE;
+    // Connection generation it was queued for, and a unique id so the loop
+    // can tell its message apart after unlocking around lws_write()
+    uint64_t generation = 0;
+    uint64_t seq = 0;
   };
 
   std::queue<QueuedMessage> _sendQueue;
+  uint64_t _nextSendSeq = 0;  // guarded by _sendMutex
+  // Waiting for the queue and lws' own output buffer to empty (see whenDrained)
+  std::vector<std::function<void(bool)>> _drainWaiters;
   std::mutex _sendMutex;
-  
-  // ============================================================
-  // Service thread for I/O
-  // ============================================================
-  
-  std::thread _serviceThread;
-  std::atomic<bool> _running{false};
+  // Set while a writable request is queued on the loop (coalesces send bursts)
+  std::atomic<bool> _writeRequested{false};
   
   // ============================================================
   // Callbacks (thread-safe)
@@ -174,8 +458,11 @@ private:
   std::optional<std::function<void()>> _onOpen;
   std::optional<std::function<void(const std::string&)>> _onMessage;
   std::optional<std::function<void(const std::shared_ptr<ArrayBuffer>&)>> _onBinaryMessage;
+  std::optional<std::function<void(const std::shared_ptr<AnyMap>&)>> _onMsgPackMessage;
+  std::optional<std::function<void(const std::shared_ptr<AnyMap>&)>> _onCborMessage;
   std::optional<std::function<void(const std::string&)>> _onError;
   std::optional<std::function<void(double, const std::string&)>> _onClose;
+  std::optional<std::function<void(double, double)>> _onReconnect;
   std::mutex _callbackMutex;
   
   // ============================================================
@@ -183,7 +470,97 @@ private:
   // ============================================================
 
   int _pingIntervalMs = 30000; // 30 seconds default
+  std::atomic<int> _pongTimeoutMs{0};  // 0 = no pong deadline
+  std::atomic<bool> _queueWhileConnecting{false};
+  std::atomic<bool> _drainOnClose{true};
+  std::atomic<double> _closeTimeoutMs{5000};
+
+  struct ReconnectConfig {
+    double initialDelayMs = 500;
+    double maxDelayMs = 30000;
+    double multiplier = 2;
+    double jitter = 0.2;
+    uint32_t maxAttempts = 0;  // 0 = unlimited
+    double stableAfterMs = 5000;
+  };
+  std::optional<ReconnectConfig> _reconnectConfig;  // nullopt = disabled
+  std::vector<std::string> _openMessages;
+  std::mutex _reconnectMutex;  // guards _reconnectConfig and _openMessages
   std::string _caPath;  // CA certificate path (empty = disable verification)
+  std::string _tlsCaPath;  // resolved by connect() for the loop (loop thread only)
+
+  static constexpr size_t MIN_RX_BUFFER_SIZE = 1024;
+  static constexpr size_t MAX_RX_BUFFER_SIZE = 16 * 1024 * 1024;
+  size_t _rxBufferSize = 65536; // 64 KB default
+  size_t _maxMessageSize = 0;   // 0 = unlimited
+
+  // ============================================================
+  // Receive reassembly (service thread only)
+  // ============================================================
+
+  std::vector<uint8_t> _rxMessage;
+  bool _rxIsBinary = false;
+
+  // ============================================================
+  // Closing phase (loop thread only)
+  // ============================================================
+
+  bool _closeRequested = false;  // close() reached the loop
+  bool _closeDrain = true;       // snapshot of the option at close()
+  bool _closeTimedOut = false;
+  bool _pongTimedOut = false;  // dropped for a missing pong
+  int _closeCode = LWS_CLOSE_STATUS_NORMAL;
+  std::string _closeReason;
+  // From the peer's close frame (0 = none received)
+  int _peerCloseCode = 0;
+  std::string _peerCloseReason;
+
+  // ============================================================
+  // Native sinks (copy-on-write, read on the service thread)
+  // ============================================================
+
+  using SinkList = std::vector<std::shared_ptr<NativeMessageSink>>;
+  std::shared_ptr<const SinkList> _sinks;
+  std::mutex _sinkMutex;
+  std::string _nativeName;  // registry name, guarded by _sinkMutex
+
+  // ============================================================
+  // State store (null = disabled)
+  // ============================================================
+
+  std::shared_ptr<StateStore> _stateStore;
+  std::mutex _stateStoreMutex;
+
+  // ============================================================
+  // Receive ring (null = per-message callbacks)
+  // ============================================================
+
+  std::shared_ptr<ReceiveRing> _receiveRing;
+  std::mutex _receiveRingMutex;
+
+  // ============================================================
+  // Channels (null until the first openChannel())
+  // ============================================================
+
+  std::shared_ptr<ChannelMux> _channelMux;
+  std::mutex _channelMuxMutex;
+
+  /**
+   * The mux, created and attached as a sink on first use (openChannel only:
+   * once attached it consumes every frame that looks like a channel frame)
+   */
+  std::shared_ptr<ChannelMux> channelMux();
+
+  /**
+   * The mux if a channel was ever opened, else null
+   */
+  std::shared_ptr<ChannelMux> existingChannelMux();
+
+  /**
+   * Validate a JS channel id (0..65535)
+   * @throws std::invalid_argument otherwise
+   */
+  static uint16_t channelId(double id);
 
   // ============================================================
   // Ping/Pong tracking
@@ -191,6 +568,71 @@ private:
 
   std::atomic<bool> _pingPending{false};
 
+  // Rolling RTT window, written on the loop thread
+  static constexpr size_t RTT_WINDOW = 64;
+  std::vector<double> _rttSamples;  // ring of the last RTT_WINDOW samples
+  size_t _rttNext = 0;
+  double _lastRttMs = 0;
+  std::mutex _rttMutex;
+  std::atomic<uint64_t> _pingsSent{0};
+  std::atomic<uint64_t> _pongsReceived{0};
+  std::atomic<uint64_t> _pongTimeouts{0};
+
+  // ============================================================
+  // Adaptive keep-alive
+  // ============================================================
+
+  struct KeepaliveConfig {
+    double minIntervalMs = 10000;
+    double maxIntervalMs = 240000;
+    std::string networkKey;
+  };
+  std::optional<KeepaliveConfig> _keepaliveConfig;  // nullopt = fixed interval
+  std::mutex _keepaliveMutex;
+
+  // Loop thread: snapshot of the config for the current connection
+  std::optional<KeepaliveConfig> _activeKeepalive;
+  std::string _keepaliveKey;  // "<networkKey>|<host>:<port>"
+  std::atomic<int> _keepaliveIntervalMs{0};  // 0 = fixed interval
+  uint32_t _keepaliveConfirmations = 0;
+
+  /**
+   * Interval until the next ping (loop thread)
+   */
+  int pingIntervalMs() const;
+
+  /**
+   * Pick the interval for a new connection and start the ping timer
+   */
+  void startKeepalive(Link& link, struct lws* wsi);
+
+  /**
+   * A ping sent after a whole idle interval was answered: grow the
+   * interval once it has held long enough
+   */
+  void keepaliveConfirmed();
+
+  /**
+   * The connection closed: shrink the interval if it died of idleness
+   */
+  void keepaliveClosed(const Link& link);
+
+  /**
+   * Write a sequenced ping and arm the pong deadline (loop thread)
+   * @return -1 if the write failed
+   */
+  int sendPing(Link& link, struct lws* wsi);
+
+  /**
+   * Match a pong against the latest ping and record the RTT (loop thread)
+   */
+  void onPong(Link& link, const uint8_t* payload, size_t len);
+
+  /**
+   * Pong deadline expired: drop the connection (onClose reports 1006)
+   */
+  static void onPongTimeout(lws_sorted_usec_list_t* sul);
+
   // ============================================================
   // Performance metrics (atomic for lock-free reads)
   // ============================================================
@@ -199,26 +641,293 @@ private:
   std::atomic<uint64_t> _messagesReceived{0};
   std::atomic<uint64_t> _bytesSent{0};
   std::atomic<uint64_t> _bytesReceived{0};
+
+  // connect() call -> handshake complete (loop thread only)
+  std::chrono::steady_clock::time_point _connectStarted;
+  std::atomic<double> _lastConnectMs{0};
+  std::atomic<uint64_t> _connects{0};
+  std::atomic<bool> _vhostReused{false};
+  std::atomic<uint64_t> _reconnects{0};
+  // TLS handshakes completed / of those, resumed from a cached session
+  std::atomic<uint64_t> _tlsHandshakes{0};
+  std::atomic<uint64_t> _tlsResumed{0};
+  // Connects won by an attempt other than the first (IPv4 or another endpoint)
+  std::atomic<uint64_t> _raceFallbacks{0};
+  // connect() calls served by a preconnected socket
+  std::atomic<uint64_t> _warmAdopted{0};
+
+  // ============================================================
+  // Pending connect (loop thread only)
+  // ============================================================
+
+  // Settled on ESTABLISHED, CONNECTION_ERROR, timeout or cleanup()
+  std::shared_ptr<Promise<void>> _connectPromise;
+  // Kept for reconnect attempts
+  std::string _subprotocols;  // Sec-WebSocket-Protocol value
+  std::vector<std::pair<std::string, std::string>> _handshakeHeaders;
+  std::optional<double> _connectTimeoutMs;
+  bool _happyEyeballs = true;
+  std::vector<Endpoint> _endpoints;  // [0] = the URL passed to connect()
+  EndpointStrategy _endpointStrategy = EndpointStrategy::PRIORITY;
+  int _failoverDelayMs = DEFAULT_FAILOVER_DELAY_MS;
+  SocketTuning _socketTuning;
+  std::string _endpointUrl;  // connected endpoint; guarded by _lifecycleMutex
+  uint32_t _reconnectAttempt = 0;  // since the last stable connection
   
   // ============================================================
   // Private methods
   // ============================================================
   
   /**
-   * Parse WebSocket URL
-   * @return true if valid, false otherwise
+   * Throw unless OPEN (or CONNECTING with queueWhileConnecting)
    */
-  bool parseUrl(const std::string& url);
-  
+  void ensureCanSend();
+
+  /**
+   * Push a message and request a write if the socket is open
+   */
+  void enqueue(QueuedMessage&& msg);
+
+  /**
+   * Queue an encoded-on-send object and wake the service thread
+   */
+  void enqueueEncoded(const std::shared_ptr<AnyMap>& value, Codec codec);
+
+  /**
+   * Deliver a complete received message (ring, state store or callbacks)
+   * Called from the service thread
+   */
+  void dispatchMessage(const uint8_t* data, size_t len, bool isBinary);
+
+  /**
+   * Report an oversized message and start a 1009 close
+   * @return -1 so the lws callback closes the connection
+   */
+  int rejectOversizedMessage(struct lws* wsi, size_t size);
+
+  /**
+   * Current sink list (null if none)
+   */
+  std::shared_ptr<const SinkList> sinks();
+
+  /**
+   * Invoke onError (if set) with the callback lock held
+   */
+  void emitError(const std::string& error);
+
+  /**
+   * Deliver a received binary frame (decoding it if a codec callback is set)
+   * Called from the service thread
+   */
+  void dispatchBinary(const uint8_t* data, size_t len);
+
+  /**
+   * Ask the loop for a WRITEABLE callback (any thread)
+   */
+  void requestWrite();
+
+  /**
+   * Write queued messages while the socket accepts data
+   * Called from LWS_CALLBACK_CLIENT_WRITEABLE
+   * @return -1 to close the connection, 0 otherwise
+   */
+  int flushSendQueue(Link& link, struct lws* wsi);
+
   /**
-   * Service loop (runs in separate thread)
+   * Closing phase step, called from WRITEABLE once close() reached the loop:
+   * flush the queue if draining, then send the close frame
+   * @return -1 to send the close frame, 0 while still draining
    */
-  void serviceLoop();
+  int continueClose(Link& link, struct lws* wsi);
+
+  /**
+   * Close deadline expired: drop the connection (onClose reports 1006)
+   */
+  static void onCloseTimeout(lws_sorted_usec_list_t* sul);
+
+  /**
+   * Code and reason reported to onClose for the connection that just closed
+   */
+  std::pair<int, std::string> closeStatus() const;
+
+  /**
+   * Report `false` to every whenDrained() waiter (connection gone)
+   */
+  void failDrainWaiters();
+
+  /**
+   * Resolve (error == nullptr) or reject the pending connect promise and
+   * cancel the connect deadline (loop thread only, no-op if none pending)
+   */
+  void settleConnect(std::exception_ptr error);
+
+  /**
+   * Connect deadline expired: abandon the attempt and reject connect()
+   */
+  static void onConnectTimeout(lws_sorted_usec_list_t* sul);
+
+  /**
+   * Create a link and start a client connection for the current URL and
+   * handshake options (loop thread only)
+   */
+  void openConnection(const std::shared_ptr<HybridWebSocket>& self, uint64_t generation);
+
+  /**
+   * An attempt failed before lws took it over: close, settle, maybe retry
+   */
+  void failConnection(Link& link, const std::string& error);
+
+  // ============================================================
+  // Warm pool (preconnect)
+  // ============================================================
+
+  // Parked sockets per process, and how long one waits for connect()
+  static constexpr size_t WARM_POOL_SIZE = 4;
+  static constexpr int WARM_TTL_MS = 30000;
+
+  class WarmBuffer;
+
+  // Set on the hidden sockets created by preconnect()
+  bool _parked = false;
+  std::shared_ptr<WarmBuffer> _warmBuffer;  // frames received while parked
+  std::string _warmKey;  // of the last connect()
+
+  /**
+   * Pool key: URL plus everything that shapes the handshake and TLS setup
+   */
+  std::string warmKey(
+    const std::string& url,
+    const std::string& subprotocols,
+    std::vector<std::pair<std::string, std::string>> headers
+  ) const;
+
+  /**
+   * Remove and return a live parked socket for `key` on `loop` (any loop
+   * if null); prunes closed ones
+   */
+  static std::shared_ptr<HybridWebSocket> takeWarm(const std::string& key, EventLoop* loop);
+
+  /**
+   * Take over `donor`'s connection (loop thread)
+   * @return false if it closed in the meantime
+   */
+  bool adoptWarm(const std::shared_ptr<HybridWebSocket>& self, HybridWebSocket& donor, uint64_t generation);
+
+  static void onParkTimeout(lws_sorted_usec_list_t* sul);
+
+  /**
+   * Handshake complete: publish OPEN, flush, start pings, notify
+   * @return -1 to close the connection
+   */
+  int onEstablished(Link& link, struct lws* wsi);
+
+  /**
+   * Start a client connection to `target` on `link`: as `wsi`, or as a
+   * racer if `wsi` is taken
+   * @return false if lws could not create the connection
+   */
+  bool startAttempt(Link& link, const Link::Target& target);
+
+  /**
+   * Start the next pending attempt (all of them without a race delay) and
+   * arm raceTimer for the rest
+   * @return false if nothing is in flight
+   */
+  bool startNext(Link& link);
+
+  // ============================================================
+  // Endpoints
+  // ============================================================
+
+  static constexpr int DEFAULT_FAILOVER_DELAY_MS = 2000;
+
+  /**
+   * Parse a ws:// or wss:// URL
+   */
+  static bool parseEndpoint(const std::string& url, Endpoint& endpoint);
+
+  /**
+   * Targets for a fresh connection, in strategy order
+   */
+  std::deque<Link::Target> endpointTargets() const;
+
+  // ============================================================
+  // Address resolution and Happy Eyeballs (RFC 8305, loop thread)
+  // ============================================================
+
+  // Head start for the IPv6 attempt before IPv4 joins the race
+  static constexpr int HAPPY_EYEBALLS_DELAY_MS = 250;
+
+  /**
+   * Resolve the endpoints' host names off the loop (system resolver), then
+   * start the attempts
+   */
+  void resolveEndpoints(const std::shared_ptr<Link>& link);
+
+  /**
+   * Every lookup has answered: queue the attempts by IP literal (an IPv6 /
+   * IPv4 race for a single host name) and start the first
+   */
+  void startTargets(Link& link);
+
+  static void onRaceTimer(lws_sorted_usec_list_t* sul);
+
+  /**
+   * `wsi` completed the handshake: keep it and drop the other attempt
+   */
+  void finishRace(Link& link, struct lws* wsi);
+
+  /**
+   * `wsi` failed; if another attempt is running or pending, continue
+   * with that one instead (failover)
+   * @return true if the connection is still in progress, or if `wsi`
+   *         failed inside startAttempt(), which reports it itself
+   */
+  bool dropAttempt(Link& link, struct lws* wsi);
+
+  /**
+   * Stop callbacks from `wsi` reaching us and release its accounting
+   */
+  static void releaseAttempt(Link& link, struct lws* wsi);
+
+  /**
+   * Schedule the next attempt on `link` if a reconnect policy applies
+   * (loop thread only, after the connection is gone)
+   */
+  void scheduleReconnect(Link& link);
+
+  static void onReconnectTimer(lws_sorted_usec_list_t* sul);
+
+  /**
+   * Put the open messages ahead of anything already queued
+   */
+  void queueOpenMessages(const Link& link);
   
   /**
-   * Cleanup resources
+   * Supersede the current connection and reset state
+   * Returns immediately; the loop detaches the old connection
    */
   void cleanup();
+
+  /**
+   * Strong reference for loop tasks
+   */
+  std::shared_ptr<HybridWebSocket> shared();
+
+  bool isCurrent(const Link& link) const {
+    return link.generation == _generation.load(std::memory_order_acquire);
+  }
+
+  /**
+   * Set the state unless cleanup() has superseded `link`
+   * @return false if superseded
+   */
+  bool transition(const Link& link, State state);
+
+  /**
+   * Stop callbacks for `link` and let lws close its socket (loop thread only)
+   */
+  static void detach(Link& link);
   
   /**
    * LibWebSockets callback handler (static)
@@ -0,0 +1,346 @@
+#include "JsonValue.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+
+namespace margelo::nitro::realtimenitro {
+
+namespace {
+
+constexpr int MAX_DEPTH = 256;
+
+// ============================================================
+// Parser
+// ============================================================
+
+class Parser {
+public:
+  explicit Parser(std::string_view text) : _text(text) {}
+
+  JsonValue parseDocument() {
+    JsonValue value = parseValue(0);
+    skipWhitespace();
+    if (_pos != _text.size()) {
+      fail("Trailing characters");
+    }
+    return value;
+  }
+
+private:
+  std::string_view _text;
+  size_t _pos = 0;
+
+  [[noreturn]] void fail(const char* message) const {
+    throw std::runtime_error(std::string(message) + " at offset " + std::to_string(_pos));
+  }
+
+  void skipWhitespace() {
+    while (_pos < _text.size()) {
+      char c = _text[_pos];
+      if (c != ' ' && c != '\t' && c != '\n' && c != '\r') break;
+      _pos++;
+    }
+  }
+
+  char peek() {
+    skipWhitespace();
+    if (_pos >= _text.size()) fail("Unexpected end of input");
+    return _text[_pos];
+  }
+
+  void expect(char c) {
+    if (peek() != c) fail("Unexpected character");
+    _pos++;
+  }
+
+  void expectLiteral(std::string_view literal) {
+    if (_text.substr(_pos, literal.size()) != literal) fail("Invalid literal");
+    _pos += literal.size();
+  }
+
+  JsonValue parseValue(int depth) {
+    if (depth > MAX_DEPTH) fail("Nesting too deep");
+
+    switch (peek()) {
+      case '{': return parseObject(depth);
+      case '[': return parseArray(depth);
+      case '"': return JsonValue(parseString());
+      case 't': expectLiteral("true"); return JsonValue(true);
+      case 'f': expectLiteral("false"); return JsonValue(false);
+      case 'n': expectLiteral("null"); return JsonValue(nullptr);
+      default: return JsonValue(parseNumber());
+    }
+  }
+
+  JsonValue parseObject(int depth) {
+    expect('{');
+    JsonValue result{JsonValue::Object{}};
+    if (peek() == '}') {
+      _pos++;
+      return result;
+    }
+    while (true) {
+      if (peek() != '"') fail("Expected object key");
+      std::string key = parseString();
+      expect(':');
+      result.set(std::move(key), parseValue(depth + 1));
+      char c = peek();
+      _pos++;
+      if (c == '}') break;
+      if (c != ',') fail("Expected ',' or '}'");
+    }
+    return result;
+  }
+
+  JsonValue parseArray(int depth) {
+    expect('[');
+    JsonValue::Array array;
+    if (peek() == ']') {
+      _pos++;
+      return JsonValue(std::move(array));
+    }
+    while (true) {
+      array.push_back(parseValue(depth + 1));
+      char c = peek();
+      _pos++;
+      if (c == ']') break;
+      if (c != ',') fail("Expected ',' or ']'");
+    }
+    return JsonValue(std::move(array));
+  }
+
+  double parseNumber() {
+    size_t start = _pos;
+    if (_pos < _text.size() && _text[_pos] == '-') _pos++;
+    while (_pos < _text.size()) {
+      char c = _text[_pos];
+      if ((c >= '0' && c <= '9') || c == '.' || c == 'e' || c == 'E' || c == '+' || c == '-') {
+        _pos++;
+      } else {
+        break;
+      }
+    }
+    if (start == _pos) fail("Unexpected character");
+
+    std::string token(_text.substr(start, _pos - start));
+    char* end = nullptr;
+    double value = std::strtod(token.c_str(), &end);
+    if (end != token.c_str() + token.size()) fail("Invalid number");
+    return value;
+  }
+
+  uint32_t parseHex4() {
+    if (_pos + 4 > _text.size()) fail("Truncated unicode escape");
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++) {
+      char c = _text[_pos++];
+      value <<= 4;
+      if (c >= '0' && c <= '9') value |= static_cast<uint32_t>(c - '0');
+      else if (c >= 'a' && c <= 'f') value |= static_cast<uint32_t>(c - 'a' + 10);
+      else if (c >= 'A' && c <= 'F') value |= static_cast<uint32_t>(c - 'A' + 10);
+      else fail("Invalid unicode escape");
+    }
+    return value;
+  }
+
+  static void appendUtf8(std::string& out, uint32_t cp) {
+    if (cp < 0x80) {
+      out += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+      out += static_cast<char>(0xc0 | (cp >> 6));
+      out += static_cast<char>(0x80 | (cp & 0x3f));
+    } else if (cp < 0x10000) {
+      out += static_cast<char>(0xe0 | (cp >> 12));
+      out += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+      out += static_cast<char>(0x80 | (cp & 0x3f));
+    } else {
+      out += static_cast<char>(0xf0 | (cp >> 18));
+      out += static_cast<char>(0x80 | ((cp >> 12) & 0x3f));
+      out += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+      out += static_cast<char>(0x80 | (cp & 0x3f));
+    }
+  }
+
+  std::string parseString() {
+    expect('"');
+    std::string out;
+    while (true) {
+      if (_pos >= _text.size()) fail("Unterminated string");
+      char c = _text[_pos++];
+      if (c == '"') break;
+      if (c != '\\') {
+        out += c;
+        continue;
+      }
+      if (_pos >= _text.size()) fail("Unterminated escape");
+      char e = _text[_pos++];
+      switch (e) {
+        case '"': out += '"'; break;
+        case '\\': out += '\\'; break;
+        case '/': out += '/'; break;
+        case 'b': out += '\b'; break;
+        case 'f': out += '\f'; break;
+        case 'n': out += '\n'; break;
+        case 'r': out += '\r'; break;
+        case 't': out += '\t'; break;
+        case 'u': {
+          uint32_t cp = parseHex4();
+          // Combine UTF-16 surrogate pairs
+          if (cp >= 0xd800 && cp <= 0xdbff &&
+              _pos + 1 < _text.size() && _text[_pos] == '\\' && _text[_pos + 1] == 'u') {
+            _pos += 2;
+            uint32_t low = parseHex4();
+            if (low >= 0xdc00 && low <= 0xdfff) {
+              cp = 0x10000 + ((cp - 0xd800) << 10) + (low - 0xdc00);
+            } else {
+              appendUtf8(out, cp);
+              cp = low;
+            }
+          }
+          appendUtf8(out, cp);
+          break;
+        }
+        default:
+          fail("Invalid escape");
+      }
+    }
+    return out;
+  }
+};
+
+// ============================================================
+// Serializer helpers
+// ============================================================
+
+void dumpString(std::string& out, const std::string& s) {
+  out += '"';
+  for (char c : s) {
+    switch (c) {
+      case '"': out += "\\\""; break;
+      case '\\': out += "\\\\"; break;
+      case '\b': out += "\\b"; break;
+      case '\f': out += "\\f"; break;
+      case '\n': out += "\\n"; break;
+      case '\r': out += "\\r"; break;
+      case '\t': out += "\\t"; break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          char buffer[8];
+          std::snprintf(buffer, sizeof(buffer), "\\u%04x", static_cast<unsigned>(c));
+          out += buffer;
+        } else {
+          out += c;
+        }
+    }
+  }
+  out += '"';
+}
+
+void dumpNumber(std::string& out, double d) {
+  if (!std::isfinite(d)) {
+    out += "null"; // JSON has no NaN/Infinity
+    return;
+  }
+  char buffer[32];
+  if (std::trunc(d) == d && std::fabs(d) < 1e15) {
+    std::snprintf(buffer, sizeof(buffer), "%.0f", d);
+  } else {
+    std::snprintf(buffer, sizeof(buffer), "%.17g", d);
+  }
+  out += buffer;
+}
+
+auto lowerBound(const JsonValue::Object& object, std::string_view key) {
+  return std::lower_bound(object.begin(), object.end(), key,
+                          [](const JsonValue::Member& m, std::string_view k) { return m.first < k; });
+}
+
+auto lowerBound(JsonValue::Object& object, std::string_view key) {
+  return std::lower_bound(object.begin(), object.end(), key,
+                          [](const JsonValue::Member& m, std::string_view k) { return m.first < k; });
+}
+
+} // namespace
+
+// ============================================================
+// JsonValue
+// ============================================================
+
+JsonValue JsonValue::parse(std::string_view text) {
+  return Parser(text).parseDocument();
+}
+
+std::string JsonValue::dump() const {
+  std::string out;
+  dumpTo(out);
+  return out;
+}
+
+void JsonValue::dumpTo(std::string& out) const {
+  if (isNull()) {
+    out += "null";
+  } else if (isBool()) {
+    out += asBool() ? "true" : "false";
+  } else if (isNumber()) {
+    dumpNumber(out, asNumber());
+  } else if (isString()) {
+    dumpString(out, asString());
+  } else if (isArray()) {
+    out += '[';
+    bool first = true;
+    for (const auto& item : asArray()) {
+      if (!first) out += ',';
+      first = false;
+      item.dumpTo(out);
+    }
+    out += ']';
+  } else {
+    out += '{';
+    bool first = true;
+    for (const auto& [key, item] : asObject()) {
+      if (!first) out += ',';
+      first = false;
+      dumpString(out, key);
+      out += ':';
+      item.dumpTo(out);
+    }
+    out += '}';
+  }
+}
+
+const JsonValue* JsonValue::find(std::string_view key) const {
+  if (!isObject()) return nullptr;
+  const auto& object = asObject();
+  auto it = lowerBound(object, key);
+  return (it != object.end() && it->first == key) ? &it->second : nullptr;
+}
+
+JsonValue* JsonValue::find(std::string_view key) {
+  if (!isObject()) return nullptr;
+  auto& object = asObject();
+  auto it = lowerBound(object, key);
+  return (it != object.end() && it->first == key) ? &it->second : nullptr;
+}
+
+JsonValue& JsonValue::set(std::string key, JsonValue value) {
+  auto& object = asObject();
+  auto it = lowerBound(object, key);
+  if (it != object.end() && it->first == key) {
+    it->second = std::move(value);
+    return it->second;
+  }
+  return object.emplace(it, std::move(key), std::move(value))->second;
+}
+
+bool JsonValue::erase(std::string_view key) {
+  auto& object = asObject();
+  auto it = lowerBound(object, key);
+  if (it == object.end() || it->first != key) return false;
+  object.erase(it);
+  return true;
+}
+
+} // namespace margelo::nitro::realtimenitro
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace margelo::nitro::realtimenitro {
+
+/**
+ * Minimal JSON document model used by native features that need to
+ * inspect or mutate JSON on the I/O thread (e.g. the state store).
+ *
+ * Objects keep their members sorted by key, so lookups are binary
+ * searches and serialization is deterministic.
+ */
+class JsonValue {
+public:
+  using Array = std::vector<JsonValue>;
+  using Member = std::pair<std::string, JsonValue>;
+  using Object = std::vector<Member>;
+
+  JsonValue() = default;
+  JsonValue(std::nullptr_t) {}
+  JsonValue(bool value) : _value(value) {}
+  JsonValue(double value) : _value(value) {}
+  JsonValue(std::string value) : _value(std::move(value)) {}
+  JsonValue(const char* value) : _value(std::string(value)) {}
+  JsonValue(Array value) : _value(std::move(value)) {}
+  JsonValue(Object value) : _value(std::move(value)) {}
+
+  /**
+   * Parse a JSON text
+   * @throws std::runtime_error on malformed input
+   */
+  static JsonValue parse(std::string_view text);
+
+  /**
+   * Serialize to compact JSON text
+   */
+  std::string dump() const;
+
+  // Type checks
+  bool isNull() const { return std::holds_alternative<std::nullptr_t>(_value); }
+  bool isBool() const { return std::holds_alternative<bool>(_value); }
+  bool isNumber() const { return std::holds_alternative<double>(_value); }
+  bool isString() const { return std::holds_alternative<std::string>(_value); }
+  bool isArray() const { return std::holds_alternative<Array>(_value); }
+  bool isObject() const { return std::holds_alternative<Object>(_value); }
+
+  // Accessors (undefined behaviour if the type does not match)
+  bool asBool() const { return std::get<bool>(_value); }
+  double asNumber() const { return std::get<double>(_value); }
+  const std::string& asString() const { return std::get<std::string>(_value); }
+  const Array& asArray() const { return std::get<Array>(_value); }
+  Array& asArray() { return std::get<Array>(_value); }
+  const Object& asObject() const { return std::get<Object>(_value); }
+  Object& asObject() { return std::get<Object>(_value); }
+
+  /**
+   * Object member lookup
+   * @return nullptr if this is not an object or the key is missing
+   */
+  const JsonValue* find(std::string_view key) const;
+  JsonValue* find(std::string_view key);
+
+  /**
+   * Insert or replace an object member (this must be an object)
+   */
+  JsonValue& set(std::string key, JsonValue value);
+
+  /**
+   * Remove an object member (this must be an object)
+   * @return true if the member existed
+   */
+  bool erase(std::string_view key);
+
+  bool operator==(const JsonValue& other) const { return _value == other._value; }
+  bool operator!=(const JsonValue& other) const { return !(*this == other); }
+
+private:
+  std::variant<std::nullptr_t, bool, double, std::string, Array, Object> _value;
+
+  void dumpTo(std::string& out) const;
+};
+
+} // namespace margelo::nitro::realtimenitro
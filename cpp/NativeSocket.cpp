@@ -0,0 +1,39 @@
+#include "NativeSocket.hpp"
+
+#include <mutex>
+#include <unordered_map>
+
+namespace margelo::nitro::realtimenitro {
+
+namespace {
+
+std::mutex registryMutex;
+std::unordered_map<std::string, std::weak_ptr<NativeSocket>> registry;
+
+} // namespace
+
+void NativeSocketRegistry::add(const std::string& name, const std::weak_ptr<NativeSocket>& socket) {
+  std::lock_guard<std::mutex> lock(registryMutex);
+  registry[name] = socket;
+}
+
+void NativeSocketRegistry::remove(const std::string& name, const NativeSocket* socket) {
+  std::lock_guard<std::mutex> lock(registryMutex);
+  auto it = registry.find(name);
+  if (it == registry.end()) {
+    return;
+  }
+  // An expired entry is always stale; a live one may belong to a newer socket
+  auto current = it->second.lock();
+  if (!current || current.get() == socket) {
+    registry.erase(it);
+  }
+}
+
+std::shared_ptr<NativeSocket> NativeSocketRegistry::find(const std::string& name) {
+  std::lock_guard<std::mutex> lock(registryMutex);
+  auto it = registry.find(name);
+  return it != registry.end() ? it->second.lock() : nullptr;
+}
+
+} // namespace margelo::nitro::realtimenitro
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace margelo::nitro::realtimenitro {
+
+/**
+ * Receiver for frames of a socket, implemented by other native modules
+ *
+ * All methods are called on the socket's event loop thread. Keep them
+ * short and non-blocking (copy into your own queue or ring if the work
+ * is heavy); a slow sink delays every socket on that loop.
+ */
+class NativeMessageSink {
+public:
+  virtual ~NativeMessageSink() = default;
+
+  /**
+   * A complete message was received
+   *
+   * `data` is only valid for the duration of the call.
+   *
+   * @return true to consume the message (it is not delivered to JS),
+   *         false to let it continue to the JS callbacks
+   */
+  virtual bool onMessage(const uint8_t* data, size_t len, bool isBinary) = 0;
+
+  virtual void onOpen() {}
+
+  /**
+   * The connection closed, or failed to open (code 1006)
+   */
+  virtual void onClose(int code, const std::string& reason) {}
+};
+
+/**
+ * Native-to-native view of a WebSocket, bypassing JSI
+ *
+ * JS publishes a socket under a name with `registerNative(name)`; native
+ * code looks it up with `NativeSocketRegistry::find(name)` and attaches
+ * sinks or sends frames directly.
+ *
+ * Thread Safety:
+ * - All methods are thread-safe
+ * - Sinks should not hold a strong reference to the socket (use the
+ *   registry or a weak_ptr), or the socket is never released
+ */
+class NativeSocket {
+public:
+  virtual ~NativeSocket() = default;
+
+  virtual void addSink(const std::shared_ptr<NativeMessageSink>& sink) = 0;
+  virtual void removeSink(const std::shared_ptr<NativeMessageSink>& sink) = 0;
+
+  /**
+   * Queue a frame (same queue and ordering as JS sends)
+   * @return false if the socket cannot send right now
+   */
+  virtual bool sendNative(const uint8_t* data, size_t len, bool isBinary) = 0;
+
+  /**
+   * Call `callback` once everything queued so far has been handed to the
+   * kernel (true), or the connection closed first (false)
+   *
+   * Called on the loop thread, or inline if the socket is not connected.
+   */
+  virtual void whenDrained(std::function<void(bool drained)> callback) = 0;
+
+  virtual bool isOpen() const = 0;
+};
+
+/**
+ * Process-wide name -> socket lookup
+ *
+ * Holds weak references only: a registered socket is still released when
+ * JS drops it, after which `find()` returns nullptr.
+ */
+class NativeSocketRegistry {
+public:
+  /**
+   * Publish `socket` under `name`, replacing any previous entry
+   */
+  static void add(const std::string& name, const std::weak_ptr<NativeSocket>& socket);
+
+  /**
+   * Remove `name` if it still refers to `socket`
+   */
+  static void remove(const std::string& name, const NativeSocket* socket);
+
+  /**
+   * @return The live socket registered under `name`, or nullptr
+   */
+  static std::shared_ptr<NativeSocket> find(const std::string& name);
+};
+
+} // namespace margelo::nitro::realtimenitro
@@ -0,0 +1,88 @@
+#include "ReceiveRing.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace margelo::nitro::realtimenitro {
+
+namespace {
+
+constexpr size_t MIN_CAPACITY = 4096;
+constexpr size_t MAX_CAPACITY = size_t(1) << 30;
+constexpr uint32_t RECORD_HEADER_SIZE = 8;
+
+constexpr uint32_t align8(size_t n) {
+  return static_cast<uint32_t>((n + 7) & ~size_t(7));
+}
+
+void storeU32(uint8_t* p, uint32_t v) {
+  std::memcpy(p, &v, sizeof(v));
+}
+
+} // namespace
+
+ReceiveRing::ReceiveRing(size_t capacity) {
+  _capacity = align8(std::clamp(capacity, MIN_CAPACITY, MAX_CAPACITY));
+
+  // 64-byte alignment keeps the header on its own cache line
+  size_t total = HEADER_SIZE + _capacity;
+  _memory = static_cast<uint8_t*>(::operator new(total, std::align_val_t(64)));
+  std::memset(_memory, 0, total);
+
+  _header = new (_memory) Header();
+  _header->capacity = _capacity;
+}
+
+ReceiveRing::~ReceiveRing() {
+  _header->~Header();
+  ::operator delete(_memory, std::align_val_t(64));
+}
+
+bool ReceiveRing::write(const uint8_t* data, size_t len, bool isBinary) {
+  uint32_t head = _header->head.load(std::memory_order_relaxed);
+  uint32_t tail = _header->tail.load(std::memory_order_acquire);
+
+  size_t recordSize = align8(RECORD_HEADER_SIZE + len);
+  // Keep one slot free so head == tail always means "empty"
+  uint32_t used = (head + _capacity - tail) % _capacity;
+  size_t free = _capacity - used - RECORD_HEADER_SIZE;
+
+  bool wraps = head + recordSize > _capacity;
+  size_t needed = wraps ? (_capacity - head) + recordSize : recordSize;
+
+  if (len > UINT32_MAX - RECORD_HEADER_SIZE || needed > free) {
+    _header->dropped.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  uint8_t* area = _memory + HEADER_SIZE;
+  if (wraps) {
+    storeU32(area + head, WRAP_MARKER);
+    head = 0;
+  }
+
+  storeU32(area + head, static_cast<uint32_t>(len));
+  storeU32(area + head + 4, isBinary ? FLAG_BINARY : 0);
+  std::memcpy(area + head + RECORD_HEADER_SIZE, data, len);
+
+  uint32_t next = head + static_cast<uint32_t>(recordSize);
+  if (next == _capacity) {
+    next = 0;
+  }
+
+  _header->frames.fetch_add(1, std::memory_order_relaxed);
+  // Release: payload bytes become visible before the new head
+  _header->head.store(next, std::memory_order_release);
+  return true;
+}
+
+uint32_t ReceiveRing::sync(uint32_t consumedTail) {
+  if (consumedTail < _capacity && (consumedTail & 7) == 0) {
+    _header->tail.store(consumedTail, std::memory_order_release);
+  }
+  return _header->head.load(std::memory_order_acquire);
+}
+
+} // namespace margelo::nitro::realtimenitro
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace margelo::nitro::realtimenitro {
+
+/**
+ * Single-producer / single-consumer byte ring for received frames
+ *
+ * The whole allocation (header + data area) is exposed to JS as one
+ * long-lived ArrayBuffer. The I/O thread appends records and publishes
+ * `head`; JS parses records and hands its consumed position back via
+ * `sync()`, so there is no per-message allocation or cross-thread call.
+ *
+ * Memory layout (little-endian, offsets in bytes):
+ *
+ *   0   u32 head       write offset in data area (published by I/O thread)
+ *   4   u32 tail       read offset in data area (published by sync())
+ *   8   u32 capacity   size of the data area
+ *   12  u32 dropped    frames dropped because the ring was full
+ *   16  u32 frames     frames written since creation
+ *   64  data area
+ *
+ * Record layout (8-byte aligned):
+ *
+ *   u32 length | u32 flags (bit 0 = binary) | payload | padding
+ *
+ * A length of 0xFFFFFFFF is a wrap marker: continue reading at offset 0.
+ * When the consumer falls behind, new frames are dropped (never
+ * overwritten) and `dropped` is incremented.
+ */
+class ReceiveRing {
+public:
+  static constexpr size_t HEADER_SIZE = 64;
+  static constexpr uint32_t WRAP_MARKER = 0xFFFFFFFF;
+  static constexpr uint32_t FLAG_BINARY = 1;
+
+  /**
+   * @param capacity Data area size in bytes (rounded up to 8, clamped to 4 KB..1 GB)
+   */
+  explicit ReceiveRing(size_t capacity);
+  ~ReceiveRing();
+
+  ReceiveRing(const ReceiveRing&) = delete;
+  ReceiveRing& operator=(const ReceiveRing&) = delete;
+
+  /**
+   * Append a frame (producer / I/O thread only)
+   * @return false if the frame was dropped because it did not fit
+   */
+  bool write(const uint8_t* data, size_t len, bool isBinary);
+
+  /**
+   * Publish the consumer position and fetch the producer position
+   * (consumer / JS thread only)
+   *
+   * @param consumedTail Offset up to which the consumer has finished reading
+   * @return Current head offset
+   */
+  uint32_t sync(uint32_t consumedTail);
+
+  uint8_t* data() { return _memory; }
+  size_t size() const { return HEADER_SIZE + _capacity; }
+
+private:
+  struct Header {
+    std::atomic<uint32_t> head;
+    std::atomic<uint32_t> tail;
+    uint32_t capacity;
+    std::atomic<uint32_t> dropped;
+    std::atomic<uint32_t> frames;
+  };
+
+  static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t),
+                "Ring header must match the documented JS layout");
+  static_assert(sizeof(Header) <= HEADER_SIZE, "Ring header too large");
+
+  uint8_t* _memory = nullptr;
+  uint32_t _capacity = 0;
+  Header* _header = nullptr;
+};
+
+} // namespace margelo::nitro::realtimenitro
@@ -0,0 +1,397 @@
+#include "StateStore.hpp"
+
+#include <functional>
+#include <stdexcept>
+#include <string_view>
+
+namespace margelo::nitro::realtimenitro {
+
+namespace {
+
+// ============================================================
+// JSON Pointer (RFC 6901)
+// ============================================================
+
+using Tokens = std::vector<std::string>;
+using UndoLog = std::vector<std::function<void(JsonValue&)>>;
+
+Tokens parsePointer(const std::string& pointer) {
+  Tokens tokens;
+  if (pointer.empty()) {
+    return tokens;
+  }
+  if (pointer[0] != '/') {
+    throw std::runtime_error("Invalid JSON pointer: " + pointer);
+  }
+  std::string token;
+  for (size_t i = 1; i <= pointer.size(); i++) {
+    if (i == pointer.size() || pointer[i] == '/') {
+      tokens.push_back(std::move(token));
+      token.clear();
+    } else if (pointer[i] == '~' && i + 1 < pointer.size() && pointer[i + 1] == '0') {
+      token += '~';
+      i++;
+    } else if (pointer[i] == '~' && i + 1 < pointer.size() && pointer[i + 1] == '1') {
+      token += '/';
+      i++;
+    } else {
+      token += pointer[i];
+    }
+  }
+  return tokens;
+}
+
+std::string escapeToken(const std::string& token) {
+  std::string out;
+  out.reserve(token.size());
+  for (char c : token) {
+    if (c == '~') out += "~0";
+    else if (c == '/') out += "~1";
+    else out += c;
+  }
+  return out;
+}
+
+size_t parseIndex(const std::string& token, size_t limit) {
+  if (token.empty() || (token.size() > 1 && token[0] == '0')) {
+    throw std::runtime_error("Invalid array index: " + token);
+  }
+  size_t index = 0;
+  for (char c : token) {
+    if (c < '0' || c > '9') {
+      throw std::runtime_error("Invalid array index: " + token);
+    }
+    index = index * 10 + static_cast<size_t>(c - '0');
+    if (index > limit) {
+      throw std::runtime_error("Array index out of range: " + token);
+    }
+  }
+  return index;
+}
+
+JsonValue& resolve(JsonValue& root, const Tokens& tokens, size_t count) {
+  JsonValue* current = &root;
+  for (size_t i = 0; i < count; i++) {
+    const std::string& token = tokens[i];
+    if (current->isObject()) {
+      current = current->find(token);
+      if (!current) {
+        throw std::runtime_error("Path not found: /" + token);
+      }
+    } else if (current->isArray()) {
+      auto& array = current->asArray();
+      if (array.empty()) {
+        throw std::runtime_error("Array index out of range: " + token);
+      }
+      current = &array[parseIndex(token, array.size() - 1)];
+    } else {
+      throw std::runtime_error("Cannot traverse into a scalar at: " + token);
+    }
+  }
+  return *current;
+}
+
+// ============================================================
+// Primitive operations (each records its inverse in the undo log)
+// ============================================================
+
+void addAt(JsonValue& root, const Tokens& tokens, JsonValue value, UndoLog& undo) {
+  if (tokens.empty()) {
+    undo.push_back([old = root](JsonValue& r) { r = old; });
+    root = std::move(value);
+    return;
+  }
+  JsonValue& parent = resolve(root, tokens, tokens.size() - 1);
+  const std::string& last = tokens.back();
+
+  if (parent.isArray()) {
+    auto& array = parent.asArray();
+    size_t index = last == "-" ? array.size() : parseIndex(last, array.size());
+    array.insert(array.begin() + static_cast<std::ptrdiff_t>(index), std::move(value));
+    undo.push_back([tokens, index](JsonValue& r) {
+      auto& a = resolve(r, tokens, tokens.size() - 1).asArray();
+      a.erase(a.begin() + static_cast<std::ptrdiff_t>(index));
+    });
+  } else if (parent.isObject()) {
+    if (const JsonValue* existing = parent.find(last)) {
+      undo.push_back([tokens, old = *existing](JsonValue& r) {
+        resolve(r, tokens, tokens.size() - 1).set(tokens.back(), old);
+      });
+    } else {
+      undo.push_back([tokens](JsonValue& r) {
+        resolve(r, tokens, tokens.size() - 1).erase(tokens.back());
+      });
+    }
+    parent.set(last, std::move(value));
+  } else {
+    throw std::runtime_error("Cannot add into a scalar");
+  }
+}
+
+JsonValue removeAt(JsonValue& root, const Tokens& tokens, UndoLog& undo) {
+  if (tokens.empty()) {
+    throw std::runtime_error("Cannot remove the document root");
+  }
+  JsonValue& parent = resolve(root, tokens, tokens.size() - 1);
+  const std::string& last = tokens.back();
+
+  if (parent.isArray()) {
+    auto& array = parent.asArray();
+    if (array.empty()) {
+      throw std::runtime_error("Array index out of range: " + last);
+    }
+    size_t index = parseIndex(last, array.size() - 1);
+    JsonValue removed = std::move(array[index]);
+    array.erase(array.begin() + static_cast<std::ptrdiff_t>(index));
+    undo.push_back([tokens, index, old = removed](JsonValue& r) {
+      auto& a = resolve(r, tokens, tokens.size() - 1).asArray();
+      a.insert(a.begin() + static_cast<std::ptrdiff_t>(index), old);
+    });
+    return removed;
+  }
+  if (parent.isObject()) {
+    JsonValue* existing = parent.find(last);
+    if (!existing) {
+      throw std::runtime_error("Path not found: /" + last);
+    }
+    JsonValue removed = std::move(*existing);
+    parent.erase(last);
+    undo.push_back([tokens, old = removed](JsonValue& r) {
+      resolve(r, tokens, tokens.size() - 1).set(tokens.back(), old);
+    });
+    return removed;
+  }
+  throw std::runtime_error("Cannot remove from a scalar");
+}
+
+void replaceAt(JsonValue& root, const Tokens& tokens, JsonValue value, UndoLog& undo) {
+  JsonValue& target = resolve(root, tokens, tokens.size());
+  undo.push_back([tokens, old = target](JsonValue& r) {
+    resolve(r, tokens, tokens.size()) = old;
+  });
+  target = std::move(value);
+}
+
+const JsonValue& member(const JsonValue& op, const char* name) {
+  const JsonValue* value = op.find(name);
+  if (!value) {
+    throw std::runtime_error(std::string("Patch operation is missing '") + name + "'");
+  }
+  return *value;
+}
+
+const std::string& stringMember(const JsonValue& op, const char* name) {
+  const JsonValue& value = member(op, name);
+  if (!value.isString()) {
+    throw std::runtime_error(std::string("Patch member '") + name + "' must be a string");
+  }
+  return value.asString();
+}
+
+bool isPrefix(const Tokens& prefix, const Tokens& tokens) {
+  if (prefix.size() >= tokens.size()) return false;
+  for (size_t i = 0; i < prefix.size(); i++) {
+    if (prefix[i] != tokens[i]) return false;
+  }
+  return true;
+}
+
+} // namespace
+
+// ============================================================
+// StateStore
+// ============================================================
+
+StateStore::PatchFormat StateStore::parseFormat(const std::string& name) {
+  if (name == "json-patch") return PatchFormat::JSON_PATCH;
+  if (name == "merge-patch") return PatchFormat::MERGE_PATCH;
+  throw std::invalid_argument("Unknown patch format: " + name + " (expected 'json-patch' or 'merge-patch')");
+}
+
+bool StateStore::consume(const char* data, size_t len, std::string& error) {
+  std::string_view text(data, len);
+
+  // Cheap pre-filter so regular messages are never fully parsed here
+  size_t first = text.find_first_not_of(" \t\r\n");
+  if (first == std::string_view::npos || text[first] != '{') {
+    return false;
+  }
+  if (text.find("\"key\"") == std::string_view::npos ||
+      (text.find("\"snapshot\"") == std::string_view::npos &&
+       text.find("\"patch\"") == std::string_view::npos)) {
+    return false;
+  }
+
+  JsonValue envelope;
+  try {
+    envelope = JsonValue::parse(text);
+  } catch (...) {
+    return false; // Not JSON: let onMessage have it
+  }
+
+  // A string `key` marks the envelope; app messages that merely have a
+  // "snapshot" or "patch" member pass through to onMessage
+  const JsonValue* keyValue = envelope.find("key");
+  if (!keyValue || !keyValue->isString()) {
+    return false;
+  }
+  const JsonValue* snapshot = envelope.find("snapshot");
+  const JsonValue* patch = envelope.find("patch");
+  if (!snapshot) {
+    bool wellFormed = patch && (_format == PatchFormat::JSON_PATCH ? patch->isArray() : patch->isObject());
+    if (!wellFormed) {
+      return false;
+    }
+  }
+  const std::string& key = keyValue->asString();
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  Document& doc = _documents[key];
+
+  try {
+    if (snapshot) {
+      doc.value = *snapshot;
+      doc.changedPaths.clear();
+      markChanged(doc, "");
+    } else if (_format == PatchFormat::JSON_PATCH) {
+      applyJsonPatch(doc, *patch);
+    } else {
+      applyMergePatch(doc, doc.value, *patch, "");
+    }
+  } catch (const std::exception& e) {
+    error = "State patch for key '" + key + "' failed: " + e.what();
+    return true;
+  }
+
+  doc.version++;
+  return true;
+}
+
+void StateStore::markChanged(Document& doc, const std::string& path) {
+  if (doc.changedPaths.count("")) {
+    return; // Whole document already marked
+  }
+  if (path.empty() || doc.changedPaths.size() >= MAX_CHANGED_PATHS) {
+    doc.changedPaths.clear();
+    doc.changedPaths.insert("");
+    return;
+  }
+  doc.changedPaths.insert(path);
+}
+
+void StateStore::applyJsonPatch(Document& doc, const JsonValue& patch) {
+  if (!patch.isArray()) {
+    throw std::runtime_error("JSON Patch must be an array");
+  }
+
+  UndoLog undo;
+  std::vector<std::string> changed;
+
+  try {
+    for (const JsonValue& op : patch.asArray()) {
+      const std::string& name = stringMember(op, "op");
+      const std::string& path = stringMember(op, "path");
+      Tokens tokens = parsePointer(path);
+
+      if (name == "add") {
+        addAt(doc.value, tokens, member(op, "value"), undo);
+        changed.push_back(path);
+      } else if (name == "remove") {
+        removeAt(doc.value, tokens, undo);
+        changed.push_back(path);
+      } else if (name == "replace") {
+        replaceAt(doc.value, tokens, member(op, "value"), undo);
+        changed.push_back(path);
+      } else if (name == "move") {
+        const std::string& from = stringMember(op, "from");
+        Tokens fromTokens = parsePointer(from);
+        if (isPrefix(fromTokens, tokens)) {
+          throw std::runtime_error("Cannot move a value into one of its children");
+        }
+        JsonValue value = removeAt(doc.value, fromTokens, undo);
+        addAt(doc.value, tokens, std::move(value), undo);
+        changed.push_back(from);
+        changed.push_back(path);
+      } else if (name == "copy") {
+        Tokens fromTokens = parsePointer(stringMember(op, "from"));
+        JsonValue value = resolve(doc.value, fromTokens, fromTokens.size());
+        addAt(doc.value, tokens, std::move(value), undo);
+        changed.push_back(path);
+      } else if (name == "test") {
+        if (resolve(doc.value, tokens, tokens.size()) != member(op, "value")) {
+          throw std::runtime_error("Test failed at " + path);
+        }
+      } else {
+        throw std::runtime_error("Unknown patch operation: " + name);
+      }
+    }
+  } catch (...) {
+    // RFC 6902: a patch is applied atomically, so roll back what we did
+    for (auto it = undo.rbegin(); it != undo.rend(); ++it) {
+      (*it)(doc.value);
+    }
+    throw;
+  }
+
+  for (const auto& path : changed) {
+    markChanged(doc, path);
+  }
+}
+
+void StateStore::applyMergePatch(Document& doc, JsonValue& target, const JsonValue& patch, const std::string& path) {
+  if (!patch.isObject()) {
+    target = patch;
+    markChanged(doc, path);
+    return;
+  }
+  if (!target.isObject()) {
+    target = JsonValue(JsonValue::Object{});
+    markChanged(doc, path);
+  }
+  for (const auto& [key, value] : patch.asObject()) {
+    std::string childPath = path + "/" + escapeToken(key);
+    if (value.isNull()) {
+      if (target.erase(key)) {
+        markChanged(doc, childPath);
+      }
+    } else if (JsonValue* existing = target.find(key)) {
+      applyMergePatch(doc, *existing, value, childPath);
+    } else {
+      JsonValue& inserted = target.set(key, JsonValue(nullptr));
+      applyMergePatch(doc, inserted, value, childPath);
+    }
+  }
+}
+
+std::optional<std::string> StateStore::snapshot(const std::string& key) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto it = _documents.find(key);
+  if (it == _documents.end() || it->second.version == 0) {
+    return std::nullopt;
+  }
+  Document& doc = it->second;
+  if (doc.snapshotVersion != doc.version) {
+    doc.snapshot = doc.value.dump();
+    doc.snapshotVersion = doc.version;
+  }
+  return doc.snapshot;
+}
+
+uint64_t StateStore::version(const std::string& key) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto it = _documents.find(key);
+  return it == _documents.end() ? 0 : it->second.version;
+}
+
+std::vector<std::string> StateStore::takeChangedPaths(const std::string& key) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto it = _documents.find(key);
+  if (it == _documents.end()) {
+    return {};
+  }
+  std::vector<std::string> paths(it->second.changedPaths.begin(), it->second.changedPaths.end());
+  it->second.changedPaths.clear();
+  return paths;
+}
+
+} // namespace margelo::nitro::realtimenitro
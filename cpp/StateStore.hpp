@@ -0,0 +1,93 @@
+#pragma once
+
+#include "JsonValue.hpp"
+
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace margelo::nitro::realtimenitro {
+
+/**
+ * Native keyed JSON document store fed from the receive path
+ *
+ * Text frames shaped like a state envelope are consumed on the I/O thread
+ * instead of being delivered to `onMessage`:
+ *
+ *   { "key": "orders", "snapshot": { ... } }   // replace the document
+ *   { "key": "orders", "patch": [ ... ] }      // RFC 6902 JSON Patch
+ *   { "key": "orders", "patch": { ... } }      // RFC 7386 JSON Merge Patch
+ *
+ * A string `key` is required, and a patch must be an array (JSON Patch)
+ * or an object (Merge Patch) to match the selected format; anything else
+ * is left for `onMessage`. JS reads immutable serialized snapshots,
+ * versions and changed paths at its own cadence.
+ *
+ * Thread Safety:
+ * - All public methods are thread-safe (single internal mutex)
+ */
+class StateStore {
+public:
+  enum class PatchFormat {
+    JSON_PATCH,
+    MERGE_PATCH
+  };
+
+  explicit StateStore(PatchFormat format) : _format(format) {}
+
+  /**
+   * Parse a patch format name ("json-patch" or "merge-patch")
+   * @throws std::invalid_argument for unknown names
+   */
+  static PatchFormat parseFormat(const std::string& name);
+
+  /**
+   * Try to consume a received text frame
+   *
+   * @param error Set when the frame was a state envelope but could not be applied
+   * @return true if the frame was a state envelope (even if applying it failed)
+   */
+  bool consume(const char* data, size_t len, std::string& error);
+
+  /**
+   * Serialized document for `key`, or nullopt if none exists
+   */
+  std::optional<std::string> snapshot(const std::string& key);
+
+  /**
+   * Document version (incremented per applied snapshot/patch, 0 if none)
+   */
+  uint64_t version(const std::string& key);
+
+  /**
+   * JSON Pointers changed since the last call for `key`
+   */
+  std::vector<std::string> takeChangedPaths(const std::string& key);
+
+private:
+  struct Document {
+    JsonValue value;
+    uint64_t version = 0;
+    std::set<std::string> changedPaths;
+    // Serialized snapshot, valid while snapshotVersion == version
+    std::string snapshot;
+    uint64_t snapshotVersion = 0;
+  };
+
+  // Bound on tracked changed paths per document before collapsing to "" (root)
+  static constexpr size_t MAX_CHANGED_PATHS = 1024;
+
+  PatchFormat _format;
+  std::unordered_map<std::string, Document> _documents;
+  std::mutex _mutex;
+
+  void markChanged(Document& doc, const std::string& path);
+  void applyJsonPatch(Document& doc, const JsonValue& patch);
+  void applyMergePatch(Document& doc, JsonValue& target, const JsonValue& patch, const std::string& path);
+};
+
+} // namespace margelo::nitro::realtimenitro
@@ -0,0 +1,283 @@
+#pragma once
+
+#include "HybridWebSocket.hpp"
+
+#include <coroutine>
+#include <cstdio>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace margelo::nitro::realtimenitro::coro {
+
+/**
+ * C++20 coroutine API for native consumers
+ *
+ * Wraps a HybridWebSocket so native protocol code can be written linearly:
+ *
+ *   coro::Task run(std::shared_ptr<HybridWebSocket> ws) {
+ *     coro::CoWebSocket socket(ws);
+ *     co_await socket.connect("wss://example.com/feed");
+ *     socket.send("subscribe");
+ *     while (auto message = co_await socket.receive()) {
+ *       handle(message->data, message->isBinary);
+ *     }
+ *   }
+ *
+ * Awaits complete from lws callbacks, so coroutines resume on the socket's
+ * event loop thread: keep the code between awaits short and non-blocking.
+ * Nothing here polls or spawns threads; a suspended await costs only the
+ * coroutine frame.
+ */
+
+/**
+ * Fire-and-forget coroutine: starts immediately and frees its frame when done
+ */
+struct Task {
+  struct promise_type {
+    Task get_return_object() noexcept { return {}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() noexcept {}
+    void unhandled_exception() noexcept {
+      printf("[WebSocket] Unhandled exception in WebSocket coroutine\n");
+    }
+  };
+};
+
+/**
+ * Awaits a Nitro Promise<void>; rethrows its rejection
+ */
+class PromiseAwaiter {
+public:
+  explicit PromiseAwaiter(std::shared_ptr<Promise<void>> promise) : _promise(std::move(promise)) {}
+
+  bool await_ready() const noexcept { return false; }
+
+  void await_suspend(std::coroutine_handle<> handle) {
+    // The resolved listener may resume (and destroy) this awaiter inline,
+    // so only locals are touched after registering it
+    auto promise = _promise;
+    auto* error = &_error;
+    promise->addOnResolvedListener([handle]() { handle.resume(); });
+    promise->addOnRejectedListener([handle, error](const std::exception_ptr& e) {
+      *error = e;
+      handle.resume();
+    });
+  }
+
+  void await_resume() {
+    if (_error) {
+      std::rethrow_exception(_error);
+    }
+  }
+
+private:
+  std::shared_ptr<Promise<void>> _promise;
+  std::exception_ptr _error;
+};
+
+struct Message {
+  std::vector<uint8_t> data;
+  bool isBinary;
+};
+
+class ReceiveAwaiter;
+
+/**
+ * Native sink buffering messages for a single awaiting consumer
+ */
+class MessageStream : public NativeMessageSink {
+public:
+  /**
+   * @param consume Hide received messages from the JS callbacks
+   */
+  explicit MessageStream(bool consume) : _consume(consume) {}
+
+  bool onMessage(const uint8_t* data, size_t len, bool isBinary) override;
+  void onOpen() override;
+  void onClose(int code, const std::string& reason) override;
+
+private:
+  friend class ReceiveAwaiter;
+
+  // Pop a buffered message; true if the caller need not suspend
+  bool tryReceive(std::optional<Message>& out);
+  // Park the awaiter; false if a message or close raced in (resume now)
+  bool park(ReceiveAwaiter* awaiter, std::coroutine_handle<> handle);
+
+  const bool _consume;
+  std::mutex _mutex;
+  std::deque<Message> _messages;
+  bool _closed = false;
+  ReceiveAwaiter* _waiter = nullptr;
+  std::coroutine_handle<> _handle;
+};
+
+/**
+ * Yields the next message, or nullopt once the connection has closed
+ */
+class ReceiveAwaiter {
+public:
+  explicit ReceiveAwaiter(std::shared_ptr<MessageStream> stream) : _stream(std::move(stream)) {}
+
+  bool await_ready() { return _stream->tryReceive(_message); }
+  bool await_suspend(std::coroutine_handle<> handle) { return _stream->park(this, handle); }
+  std::optional<Message> await_resume() { return std::move(_message); }
+
+private:
+  friend class MessageStream;
+
+  std::shared_ptr<MessageStream> _stream;
+  std::optional<Message> _message;
+};
+
+/**
+ * Completes once queued sends are written; yields false if the connection
+ * closed first
+ */
+class DrainAwaiter {
+public:
+  explicit DrainAwaiter(std::shared_ptr<HybridWebSocket> socket) : _socket(std::move(socket)) {}
+
+  bool await_ready() const noexcept { return false; }
+
+  void await_suspend(std::coroutine_handle<> handle) {
+    auto* drained = &_drained;
+    _socket->whenDrained([handle, drained](bool ok) {
+      *drained = ok;
+      handle.resume();
+    });
+  }
+
+  bool await_resume() const noexcept { return _drained; }
+
+private:
+  std::shared_ptr<HybridWebSocket> _socket;
+  bool _drained = false;
+};
+
+/**
+ * Coroutine view of one socket
+ *
+ * Attaches a MessageStream sink on construction and detaches it on
+ * destruction. Only one coroutine may await `receive()` at a time.
+ */
+class CoWebSocket {
+public:
+  /**
+   * @param consume Hide received messages from the JS callbacks (default)
+   */
+  explicit CoWebSocket(std::shared_ptr<HybridWebSocket> socket, bool consume = true)
+      : _socket(std::move(socket)), _stream(std::make_shared<MessageStream>(consume)) {
+    _socket->addSink(_stream);
+  }
+
+  ~CoWebSocket() {
+    _socket->removeSink(_stream);
+  }
+
+  CoWebSocket(const CoWebSocket&) = delete;
+  CoWebSocket& operator=(const CoWebSocket&) = delete;
+
+  PromiseAwaiter connect(const std::string& url, const std::optional<WebSocketOptions>& options = std::nullopt) {
+    return PromiseAwaiter(_socket->connect(url, std::nullopt, options));
+  }
+
+  ReceiveAwaiter receive() { return ReceiveAwaiter(_stream); }
+
+  DrainAwaiter drain() { return DrainAwaiter(_socket); }
+
+  /**
+   * Queue a frame (see NativeSocket::sendNative)
+   * @return false if the socket cannot send right now
+   */
+  bool send(std::string_view text) {
+    return _socket->sendNative(reinterpret_cast<const uint8_t*>(text.data()), text.size(), false);
+  }
+
+  bool send(const uint8_t* data, size_t len, bool isBinary = true) {
+    return _socket->sendNative(data, len, isBinary);
+  }
+
+  HybridWebSocket& socket() { return *_socket; }
+
+private:
+  std::shared_ptr<HybridWebSocket> _socket;
+  std::shared_ptr<MessageStream> _stream;
+};
+
+// ============================================================
+// MessageStream
+// ============================================================
+
+inline bool MessageStream::onMessage(const uint8_t* data, size_t len, bool isBinary) {
+  std::unique_lock<std::mutex> lock(_mutex);
+  if (!_waiter) {
+    _messages.push_back(Message{std::vector<uint8_t>(data, data + len), isBinary});
+    return _consume;
+  }
+
+  // Hand the message straight to the parked consumer, skipping the queue
+  _waiter->_message = Message{std::vector<uint8_t>(data, data + len), isBinary};
+  _waiter = nullptr;
+  auto handle = std::exchange(_handle, nullptr);
+  lock.unlock();
+  handle.resume();
+  return _consume;
+}
+
+inline void MessageStream::onOpen() {
+  // A reconnect reopens the stream
+  std::lock_guard<std::mutex> lock(_mutex);
+  _closed = false;
+}
+
+inline void MessageStream::onClose(int code, const std::string& reason) {
+  std::unique_lock<std::mutex> lock(_mutex);
+  _closed = true;
+  if (!_waiter) {
+    return;
+  }
+  _waiter = nullptr;
+  auto handle = std::exchange(_handle, nullptr);
+  lock.unlock();
+  handle.resume();
+}
+
+inline bool MessageStream::tryReceive(std::optional<Message>& out) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (!_messages.empty()) {
+    out = std::move(_messages.front());
+    _messages.pop_front();
+    return true;
+  }
+  return _closed;
+}
+
+inline bool MessageStream::park(ReceiveAwaiter* awaiter, std::coroutine_handle<> handle) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (!_messages.empty()) {
+    awaiter->_message = std::move(_messages.front());
+    _messages.pop_front();
+    return false;
+  }
+  if (_closed) {
+    return false;
+  }
+  if (_waiter) {
+    throw std::logic_error("Only one coroutine may await receive() at a time");
+  }
+  _waiter = awaiter;
+  _handle = handle;
+  return true;
+}
+
+} // namespace margelo::nitro::realtimenitro::coro
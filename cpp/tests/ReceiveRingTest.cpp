@@ -0,0 +1,158 @@
+/**
+ * ReceiveRing stress test: one producer thread writing faster than the
+ * consumer drains, checked against the documented record layout
+ *
+ * Standalone (no lws or Nitro). Build and run from the repository root:
+ *
+ *   c++ -std=c++20 -O2 -pthread -Icpp cpp/tests/ReceiveRingTest.cpp cpp/ReceiveRing.cpp -o /tmp/ring-test && /tmp/ring-test
+ */
+
+#include "ReceiveRing.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using margelo::nitro::realtimenitro::ReceiveRing;
+
+namespace {
+
+constexpr uint64_t FRAMES = 200000;
+constexpr size_t CAPACITY = 4096;
+constexpr size_t OVERSIZED = CAPACITY + 1000;
+
+#define CHECK(condition, ...)                                   \
+  do {                                                          \
+    if (!(condition)) {                                         \
+      printf("FAIL %s:%d: %s: ", __FILE__, __LINE__, #condition); \
+      printf(__VA_ARGS__);                                      \
+      printf("\n");                                             \
+      std::exit(1);                                             \
+    }                                                           \
+  } while (0)
+
+// Deterministic per-frame length; at least 8 bytes for the sequence number.
+// Every 997th frame is larger than the ring and must always be dropped
+size_t lengthOf(uint64_t seq) {
+  if (seq % 997 == 0) {
+    return OVERSIZED;
+  }
+  return 8 + (seq * 2654435761u) % 1500;
+}
+
+uint8_t byteOf(uint64_t seq, size_t i) {
+  return static_cast<uint8_t>(seq * 31 + i);
+}
+
+uint32_t loadU32(const uint8_t* p) {
+  uint32_t v;
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+} // namespace
+
+int main() {
+  ReceiveRing ring(CAPACITY);
+  const uint8_t* memory = ring.data();
+  const uint8_t* area = memory + ReceiveRing::HEADER_SIZE;
+  const uint32_t capacity = loadU32(memory + 8);
+  CHECK(capacity == CAPACITY, "capacity %u", capacity);
+  CHECK(ring.size() == ReceiveRing::HEADER_SIZE + CAPACITY, "size %zu", ring.size());
+
+  std::atomic<bool> done{false};
+  uint64_t accepted = 0;
+  uint64_t rejected = 0;
+
+  std::thread producer([&]() {
+    std::vector<uint8_t> frame(OVERSIZED);
+    for (uint64_t seq = 1; seq <= FRAMES; seq++) {
+      size_t len = lengthOf(seq);
+      std::memcpy(frame.data(), &seq, sizeof(seq));
+      for (size_t i = 8; i < len; i++) {
+        frame[i] = byteOf(seq, i);
+      }
+      if (ring.write(frame.data(), len, seq & 1)) {
+        accepted++;
+      } else {
+        rejected++;
+      }
+      // Still faster than the consumer, but lets enough frames through to
+      // exercise the wrap and free-space arithmetic
+      if (seq % 16 == 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds(1));
+      }
+    }
+    done.store(true, std::memory_order_release);
+  });
+
+  // Consumer: the same walk ReceiveRingReader does in JS
+  uint32_t tail = 0;
+  uint64_t lastSeq = 0;
+  uint64_t received = 0;
+  uint64_t missing = 0;
+  uint64_t wraps = 0;
+  while (true) {
+    bool finished = done.load(std::memory_order_acquire);
+    uint32_t head = ring.sync(tail);
+    while (tail != head) {
+      CHECK(tail < capacity && (tail & 7) == 0, "bad tail %u", tail);
+      uint32_t len = loadU32(area + tail);
+      if (len == ReceiveRing::WRAP_MARKER) {
+        wraps++;
+        tail = 0;
+        continue;
+      }
+      CHECK(tail + 8 + len <= capacity, "record at %u (%u bytes) overruns the data area", tail, len);
+      uint32_t flags = loadU32(area + tail + 4);
+      const uint8_t* payload = area + tail + 8;
+
+      uint64_t seq;
+      CHECK(len >= 8, "short record %u", len);
+      std::memcpy(&seq, payload, sizeof(seq));
+      CHECK(seq > lastSeq && seq <= FRAMES, "seq %llu after %llu",
+            static_cast<unsigned long long>(seq), static_cast<unsigned long long>(lastSeq));
+      CHECK(len == lengthOf(seq), "seq %llu has %u bytes", static_cast<unsigned long long>(seq), len);
+      CHECK(flags == (seq & 1 ? ReceiveRing::FLAG_BINARY : 0u), "seq %llu flags %u",
+            static_cast<unsigned long long>(seq), flags);
+      for (size_t i = 8; i < len; i++) {
+        CHECK(payload[i] == byteOf(seq, i), "seq %llu corrupt at byte %zu", static_cast<unsigned long long>(seq), i);
+      }
+      missing += seq - lastSeq - 1;
+      lastSeq = seq;
+      received++;
+
+      tail += (8 + len + 7) & ~7u;
+      if (tail == capacity) {
+        tail = 0;
+      }
+      // Slower than the producer, so the ring fills and frames get dropped
+      if (received % 32 == 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds(20));
+      }
+    }
+    if (finished && ring.sync(tail) == tail) {
+      break;
+    }
+  }
+  producer.join();
+  missing += FRAMES - lastSeq;
+
+  uint32_t dropped = loadU32(memory + 12);
+  uint32_t frames = loadU32(memory + 16);
+  CHECK(received == accepted, "received %llu, accepted %llu",
+        static_cast<unsigned long long>(received), static_cast<unsigned long long>(accepted));
+  CHECK(frames == accepted, "frames %u, accepted %llu", frames, static_cast<unsigned long long>(accepted));
+  CHECK(dropped == rejected, "dropped %u, rejected %llu", dropped, static_cast<unsigned long long>(rejected));
+  CHECK(missing == dropped, "missing %llu, dropped %u", static_cast<unsigned long long>(missing), dropped);
+  CHECK(dropped >= FRAMES / 997, "oversized frames were not all dropped (%u)", dropped);
+  CHECK(wraps > 0, "the ring never wrapped");
+
+  printf("PASS: %llu received, %u dropped, %llu wraps\n",
+         static_cast<unsigned long long>(received), dropped, static_cast<unsigned long long>(wraps));
+  return 0;
+}
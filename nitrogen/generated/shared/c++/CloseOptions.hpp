@@ -0,0 +1,73 @@
+///
+/// CloseOptions.hpp
+/// This file was generated by nitrogen. DO NOT MODIFY THIS FILE.
+/// https://github.com/mrousavy/nitro
+/// Copyright © 2026 Marc Rousavy @ Margelo
+///
+
+#pragma once
+
+#if __has_include(<NitroModules/JSIConverter.hpp>)
+#include <NitroModules/JSIConverter.hpp>
+#else
+#error NitroModules cannot be found! Are you sure you installed NitroModules properly?
+#endif
+#if __has_include(<NitroModules/NitroDefines.hpp>)
+#include <NitroModules/NitroDefines.hpp>
+#else
+#error NitroModules cannot be found! Are you sure you installed NitroModules properly?
+#endif
+
+
+
+#include <optional>
+
+namespace margelo::nitro::realtimenitro {
+
+  /**
+   * A struct which can be represented as a JavaScript object (CloseOptions).
+   */
+  struct CloseOptions {
+  public:
+    std::optional<bool> drain     SWIFT_PRIVATE;
+    std::optional<double> timeout     SWIFT_PRIVATE;
+
+  public:
+    CloseOptions() = default;
+    explicit CloseOptions(std::optional<bool> drain, std::optional<double> timeout): drain(drain), timeout(timeout) {}
+  };
+
+} // namespace margelo::nitro::realtimenitro
+
+namespace margelo::nitro {
+
+  using namespace margelo::nitro::realtimenitro;
+
+  // C++ CloseOptions <> JS CloseOptions (object)
+  template <>
+  struct JSIConverter<CloseOptions> final {
+    static inline CloseOptions fromJSI(jsi::Runtime& runtime, const jsi::Value& arg) {
+      jsi::Object obj = arg.asObject(runtime);
+      return CloseOptions(
+        JSIConverter<std::optional<bool>>::fromJSI(runtime, obj.getProperty(runtime, "drain")),
+        JSIConverter<std::optional<double>>::fromJSI(runtime, obj.getProperty(runtime, "timeout"))
+      );
+    }
+    static inline jsi::Value toJSI(jsi::Runtime& runtime, const CloseOptions& arg) {
+      jsi::Object obj(runtime);
+      obj.setProperty(runtime, "drain", JSIConverter<std::optional<bool>>::toJSI(runtime, arg.drain));
+      obj.setProperty(runtime, "timeout", JSIConverter<std::optional<double>>::toJSI(runtime, arg.timeout));
+      return obj;
+    }
+    static inline bool canConvert(jsi::Runtime& runtime, const jsi::Value& value) {
+      if (!value.isObject()) {
+        return false;
+      }
+      jsi::Object obj = value.getObject(runtime);
+      if (!JSIConverter<std::optional<bool>>::canConvert(runtime, obj.getProperty(runtime, "drain"))) return false;
+      if (!JSIConverter<std::optional<double>>::canConvert(runtime, obj.getProperty(runtime, "timeout"))) return false;
+      return true;
+    }
+  };
+
+} // namespace margelo::nitro
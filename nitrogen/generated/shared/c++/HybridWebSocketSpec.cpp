@@ -16,22 +16,65 @@ namespace margelo::nitro::realtimenitro {
     registerHybrids(this, [](Prototype& prototype) {
       prototype.registerHybridGetter("state", &HybridWebSocketSpec::getState);
       prototype.registerHybridGetter("url", &HybridWebSocketSpec::getUrl);
+      prototype.registerHybridGetter("endpoint", &HybridWebSocketSpec::getEndpoint);
       prototype.registerHybridGetter("onOpen", &HybridWebSocketSpec::getOnOpen);
       prototype.registerHybridSetter("onOpen", &HybridWebSocketSpec::setOnOpen);
       prototype.registerHybridGetter("onMessage", &HybridWebSocketSpec::getOnMessage);
       prototype.registerHybridSetter("onMessage", &HybridWebSocketSpec::setOnMessage);
       prototype.registerHybridGetter("onBinaryMessage", &HybridWebSocketSpec::getOnBinaryMessage);
       prototype.registerHybridSetter("onBinaryMessage", &HybridWebSocketSpec::setOnBinaryMessage);
+      prototype.registerHybridGetter("onMsgPackMessage", &HybridWebSocketSpec::getOnMsgPackMessage);
+      prototype.registerHybridSetter("onMsgPackMessage", &HybridWebSocketSpec::setOnMsgPackMessage);
+      prototype.registerHybridGetter("onCborMessage", &HybridWebSocketSpec::getOnCborMessage);
+      prototype.registerHybridSetter("onCborMessage", &HybridWebSocketSpec::setOnCborMessage);
       prototype.registerHybridGetter("onError", &HybridWebSocketSpec::getOnError);
       prototype.registerHybridSetter("onError", &HybridWebSocketSpec::setOnError);
       prototype.registerHybridGetter("onClose", &HybridWebSocketSpec::getOnClose);
       prototype.registerHybridSetter("onClose", &HybridWebSocketSpec::setOnClose);
+      prototype.registerHybridGetter("onReconnect", &HybridWebSocketSpec::getOnReconnect);
+      prototype.registerHybridSetter("onReconnect", &HybridWebSocketSpec::setOnReconnect);
       prototype.registerHybridMethod("connect", &HybridWebSocketSpec::connect);
       prototype.registerHybridMethod("send", &HybridWebSocketSpec::send);
       prototype.registerHybridMethod("sendBinary", &HybridWebSocketSpec::sendBinary);
+      prototype.registerHybridMethod("sendMsgPack", &HybridWebSocketSpec::sendMsgPack);
+      prototype.registerHybridMethod("sendCbor", &HybridWebSocketSpec::sendCbor);
       prototype.registerHybridMethod("close", &HybridWebSocketSpec::close);
+      prototype.registerHybridMethod("setCloseOptions", &HybridWebSocketSpec::setCloseOptions);
+      prototype.registerHybridMethod("setReconnectPolicy", &HybridWebSocketSpec::setReconnectPolicy);
+      prototype.registerHybridMethod("setOpenMessages", &HybridWebSocketSpec::setOpenMessages);
       prototype.registerHybridMethod("setPingInterval", &HybridWebSocketSpec::setPingInterval);
+      prototype.registerHybridMethod("setPongTimeout", &HybridWebSocketSpec::setPongTimeout);
+      prototype.registerHybridMethod("getPingStats", &HybridWebSocketSpec::getPingStats);
+      prototype.registerHybridMethod("setAdaptiveKeepalive", &HybridWebSocketSpec::setAdaptiveKeepalive);
+      prototype.registerHybridMethod("getKeepaliveIntervals", &HybridWebSocketSpec::getKeepaliveIntervals);
+      prototype.registerHybridMethod("setKeepaliveIntervals", &HybridWebSocketSpec::setKeepaliveIntervals);
       prototype.registerHybridMethod("setCAPath", &HybridWebSocketSpec::setCAPath);
+      prototype.registerHybridMethod("setReceiveBufferSize", &HybridWebSocketSpec::setReceiveBufferSize);
+      prototype.registerHybridMethod("setMaxMessageSize", &HybridWebSocketSpec::setMaxMessageSize);
+      prototype.registerHybridMethod("setQueueWhileConnecting", &HybridWebSocketSpec::setQueueWhileConnecting);
+      prototype.registerHybridMethod("enableStateStore", &HybridWebSocketSpec::enableStateStore);
+      prototype.registerHybridMethod("disableStateStore", &HybridWebSocketSpec::disableStateStore);
+      prototype.registerHybridMethod("getStateSnapshot", &HybridWebSocketSpec::getStateSnapshot);
+      prototype.registerHybridMethod("getStateVersion", &HybridWebSocketSpec::getStateVersion);
+      prototype.registerHybridMethod("takeStateChanges", &HybridWebSocketSpec::takeStateChanges);
+      prototype.registerHybridMethod("enableReceiveRing", &HybridWebSocketSpec::enableReceiveRing);
+      prototype.registerHybridMethod("disableReceiveRing", &HybridWebSocketSpec::disableReceiveRing);
+      prototype.registerHybridMethod("syncReceiveRing", &HybridWebSocketSpec::syncReceiveRing);
+      prototype.registerHybridMethod("openChannel", &HybridWebSocketSpec::openChannel);
+      prototype.registerHybridMethod("closeChannel", &HybridWebSocketSpec::closeChannel);
+      prototype.registerHybridMethod("sendChannel", &HybridWebSocketSpec::sendChannel);
+      prototype.registerHybridMethod("sendChannelBinary", &HybridWebSocketSpec::sendChannelBinary);
+      prototype.registerHybridMethod("getChannelStats", &HybridWebSocketSpec::getChannelStats);
+      prototype.registerHybridMethod("getEventLoopStats", &HybridWebSocketSpec::getEventLoopStats);
+      prototype.registerHybridMethod("setServiceThreadOptions", &HybridWebSocketSpec::setServiceThreadOptions);
+      prototype.registerHybridMethod("configureEventLoops", &HybridWebSocketSpec::configureEventLoops);
+      prototype.registerHybridMethod("getConnectStats", &HybridWebSocketSpec::getConnectStats);
+      prototype.registerHybridMethod("prefetchDns", &HybridWebSocketSpec::prefetchDns);
+      prototype.registerHybridMethod("preconnect", &HybridWebSocketSpec::preconnect);
+      prototype.registerHybridMethod("getEndpointLatencies", &HybridWebSocketSpec::getEndpointLatencies);
+      prototype.registerHybridMethod("setEndpointLatencies", &HybridWebSocketSpec::setEndpointLatencies);
+      prototype.registerHybridMethod("registerNative", &HybridWebSocketSpec::registerNative);
+      prototype.registerHybridMethod("unregisterNative", &HybridWebSocketSpec::unregisterNative);
     });
   }
 
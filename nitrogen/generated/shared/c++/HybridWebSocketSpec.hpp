@@ -13,14 +13,30 @@
 #error NitroModules cannot be found! Are you sure you installed NitroModules properly?
 #endif
 
-
+// Forward declaration of `WebSocketOptions` to properly resolve imports.
+namespace margelo::nitro::realtimenitro { struct WebSocketOptions; }
+// Forward declaration of `CloseOptions` to properly resolve imports.
+namespace margelo::nitro::realtimenitro { struct CloseOptions; }
+// Forward declaration of `ReconnectPolicy` to properly resolve imports.
+namespace margelo::nitro::realtimenitro { struct ReconnectPolicy; }
+// Forward declaration of `KeepalivePolicy` to properly resolve imports.
+namespace margelo::nitro::realtimenitro { struct KeepalivePolicy; }
+// Forward declaration of `ServiceThreadOptions` to properly resolve imports.
+namespace margelo::nitro::realtimenitro { struct ServiceThreadOptions; }
 
 #include <string>
 #include <functional>
 #include <optional>
 #include <NitroModules/ArrayBuffer.hpp>
+#include <NitroModules/AnyMap.hpp>
 #include <NitroModules/Promise.hpp>
 #include <vector>
+#include "WebSocketOptions.hpp"
+#include "CloseOptions.hpp"
+#include "ReconnectPolicy.hpp"
+#include <unordered_map>
+#include "KeepalivePolicy.hpp"
+#include "ServiceThreadOptions.hpp"
 
 namespace margelo::nitro::realtimenitro {
 
@@ -51,25 +67,68 @@ namespace margelo::nitro::realtimenitro {
       // Properties
       virtual double getState() = 0;
       virtual std::string getUrl() = 0;
+      virtual std::string getEndpoint() = 0;
       virtual std::optional<std::function<void()>> getOnOpen() = 0;
       virtual void setOnOpen(const std::optional<std::function<void()>>& onOpen) = 0;
       virtual std::optional<std::function<void(const std::string& /* message */)>> getOnMessage() = 0;
       virtual void setOnMessage(const std::optional<std::function<void(const std::string& /* message */)>>& onMessage) = 0;
       virtual std::optional<std::function<void(const std::shared_ptr<ArrayBuffer>& /* data */)>> getOnBinaryMessage() = 0;
       virtual void setOnBinaryMessage(const std::optional<std::function<void(const std::shared_ptr<ArrayBuffer>& /* data */)>>& onBinaryMessage) = 0;
+      virtual std::optional<std::function<void(const std::shared_ptr<AnyMap>& /* value */)>> getOnMsgPackMessage() = 0;
+      virtual void setOnMsgPackMessage(const std::optional<std::function<void(const std::shared_ptr<AnyMap>& /* value */)>>& onMsgPackMessage) = 0;
+      virtual std::optional<std::function<void(const std::shared_ptr<AnyMap>& /* value */)>> getOnCborMessage() = 0;
+      virtual void setOnCborMessage(const std::optional<std::function<void(const std::shared_ptr<AnyMap>& /* value */)>>& onCborMessage) = 0;
       virtual std::optional<std::function<void(const std::string& /* error */)>> getOnError() = 0;
       virtual void setOnError(const std::optional<std::function<void(const std::string& /* error */)>>& onError) = 0;
       virtual std::optional<std::function<void(double /* code */, const std::string& /* reason */)>> getOnClose() = 0;
       virtual void setOnClose(const std::optional<std::function<void(double /* code */, const std::string& /* reason */)>>& onClose) = 0;
+      virtual std::optional<std::function<void(double /* attempt */, double /* delayMs */)>> getOnReconnect() = 0;
+      virtual void setOnReconnect(const std::optional<std::function<void(double /* attempt */, double /* delayMs */)>>& onReconnect) = 0;
 
     public:
       // Methods
-      virtual std::shared_ptr<Promise<void>> connect(const std::string& url, const std::optional<std::vector<std::string>>& protocols) = 0;
+      virtual std::shared_ptr<Promise<void>> connect(const std::string& url, const std::optional<std::vector<std::string>>& protocols, const std::optional<WebSocketOptions>& options) = 0;
       virtual void send(const std::string& message) = 0;
       virtual void sendBinary(const std::shared_ptr<ArrayBuffer>& data) = 0;
+      virtual void sendMsgPack(const std::shared_ptr<AnyMap>& value) = 0;
+      virtual void sendCbor(const std::shared_ptr<AnyMap>& value) = 0;
       virtual void close(std::optional<double> code, const std::optional<std::string>& reason) = 0;
+      virtual void setCloseOptions(const CloseOptions& options) = 0;
+      virtual void setReconnectPolicy(const std::optional<ReconnectPolicy>& policy) = 0;
+      virtual void setOpenMessages(const std::vector<std::string>& messages) = 0;
       virtual void setPingInterval(double intervalMs) = 0;
+      virtual void setPongTimeout(double timeoutMs) = 0;
+      virtual std::unordered_map<std::string, double> getPingStats() = 0;
+      virtual void setAdaptiveKeepalive(const std::optional<KeepalivePolicy>& policy) = 0;
+      virtual std::unordered_map<std::string, double> getKeepaliveIntervals() = 0;
+      virtual void setKeepaliveIntervals(const std::unordered_map<std::string, double>& intervals) = 0;
       virtual void setCAPath(const std::string& path) = 0;
+      virtual void setReceiveBufferSize(double bytes) = 0;
+      virtual void setMaxMessageSize(double bytes) = 0;
+      virtual void setQueueWhileConnecting(bool enabled) = 0;
+      virtual void enableStateStore(const std::string& patchFormat) = 0;
+      virtual void disableStateStore() = 0;
+      virtual std::optional<std::string> getStateSnapshot(const std::string& key) = 0;
+      virtual double getStateVersion(const std::string& key) = 0;
+      virtual std::vector<std::string> takeStateChanges(const std::string& key) = 0;
+      virtual std::shared_ptr<ArrayBuffer> enableReceiveRing(double capacityBytes) = 0;
+      virtual void disableReceiveRing() = 0;
+      virtual double syncReceiveRing(double consumedTail) = 0;
+      virtual void openChannel(double id, const std::function<void(const std::string& /* message */)>& onMessage, const std::optional<std::function<void(const std::shared_ptr<ArrayBuffer>& /* data */)>>& onBinaryMessage, std::optional<double> window) = 0;
+      virtual void closeChannel(double id) = 0;
+      virtual bool sendChannel(double id, const std::string& message) = 0;
+      virtual bool sendChannelBinary(double id, const std::shared_ptr<ArrayBuffer>& data) = 0;
+      virtual std::unordered_map<std::string, double> getChannelStats(double id) = 0;
+      virtual std::unordered_map<std::string, double> getEventLoopStats() = 0;
+      virtual void setServiceThreadOptions(const ServiceThreadOptions& options) = 0;
+      virtual void configureEventLoops(double count, const std::string& assignment) = 0;
+      virtual std::unordered_map<std::string, double> getConnectStats() = 0;
+      virtual void prefetchDns(const std::string& host) = 0;
+      virtual void preconnect(const std::string& url, const std::optional<WebSocketOptions>& options) = 0;
+      virtual std::unordered_map<std::string, double> getEndpointLatencies() = 0;
+      virtual void setEndpointLatencies(const std::unordered_map<std::string, double>& latencies) = 0;
+      virtual void registerNative(const std::string& name) = 0;
+      virtual void unregisterNative() = 0;
 
     protected:
       // Hybrid Setup
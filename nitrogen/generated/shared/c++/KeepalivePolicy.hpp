@@ -0,0 +1,78 @@
+///
+/// KeepalivePolicy.hpp
+/// This file was generated by nitrogen. DO NOT MODIFY THIS FILE.
+/// https://github.com/mrousavy/nitro
+/// Copyright © 2026 Marc Rousavy @ Margelo
+///
+
+#pragma once
+
+#if __has_include(<NitroModules/JSIConverter.hpp>)
+#include <NitroModules/JSIConverter.hpp>
+#else
+#error NitroModules cannot be found! Are you sure you installed NitroModules properly?
+#endif
+#if __has_include(<NitroModules/NitroDefines.hpp>)
+#include <NitroModules/NitroDefines.hpp>
+#else
+#error NitroModules cannot be found! Are you sure you installed NitroModules properly?
+#endif
+
+
+
+#include <optional>
+#include <string>
+
+namespace margelo::nitro::realtimenitro {
+
+  /**
+   * A struct which can be represented as a JavaScript object (KeepalivePolicy).
+   */
+  struct KeepalivePolicy {
+  public:
+    std::optional<double> minInterval     SWIFT_PRIVATE;
+    std::optional<double> maxInterval     SWIFT_PRIVATE;
+    std::optional<std::string> networkKey     SWIFT_PRIVATE;
+
+  public:
+    KeepalivePolicy() = default;
+    explicit KeepalivePolicy(std::optional<double> minInterval, std::optional<double> maxInterval, std::optional<std::string> networkKey): minInterval(minInterval), maxInterval(maxInterval), networkKey(networkKey) {}
+  };
+
+} // namespace margelo::nitro::realtimenitro
+
+namespace margelo::nitro {
+
+  using namespace margelo::nitro::realtimenitro;
+
+  // C++ KeepalivePolicy <> JS KeepalivePolicy (object)
+  template <>
+  struct JSIConverter<KeepalivePolicy> final {
+    static inline KeepalivePolicy fromJSI(jsi::Runtime& runtime, const jsi::Value& arg) {
+      jsi::Object obj = arg.asObject(runtime);
+      return KeepalivePolicy(
+        JSIConverter<std::optional<double>>::fromJSI(runtime, obj.getProperty(runtime, "minInterval")),
+        JSIConverter<std::optional<double>>::fromJSI(runtime, obj.getProperty(runtime, "maxInterval")),
+        JSIConverter<std::optional<std::string>>::fromJSI(runtime, obj.getProperty(runtime, "networkKey"))
+      );
+    }
+    static inline jsi::Value toJSI(jsi::Runtime& runtime, const KeepalivePolicy& arg) {
+      jsi::Object obj(runtime);
+      obj.setProperty(runtime, "minInterval", JSIConverter<std::optional<double>>::toJSI(runtime, arg.minInterval));
+      obj.setProperty(runtime, "maxInterval", JSIConverter<std::optional<double>>::toJSI(runtime, arg.maxInterval));
+      obj.setProperty(runtime, "networkKey", JSIConverter<std::optional<std::string>>::toJSI(runtime, arg.networkKey));
+      return obj;
+    }
+    static inline bool canConvert(jsi::Runtime& runtime, const jsi::Value& value) {
+      if (!value.isObject()) {
+        return false;
+      }
+      jsi::Object obj = value.getObject(runtime);
+      if (!JSIConverter<std::optional<double>>::canConvert(runtime, obj.getProperty(runtime, "minInterval"))) return false;
+      if (!JSIConverter<std::optional<double>>::canConvert(runtime, obj.getProperty(runtime, "maxInterval"))) return false;
+      if (!JSIConverter<std::optional<std::string>>::canConvert(runtime, obj.getProperty(runtime, "networkKey"))) return false;
+      return true;
+    }
+  };
+
+} // namespace margelo::nitro
@@ -0,0 +1,89 @@
+///
+/// ReconnectPolicy.hpp
+/// This file was generated by nitrogen. DO NOT MODIFY THIS FILE.
+/// https://github.com/mrousavy/nitro
+/// Copyright © 2026 Marc Rousavy @ Margelo
+///
+
+#pragma once
+
+#if __has_include(<NitroModules/JSIConverter.hpp>)
+#include <NitroModules/JSIConverter.hpp>
+#else
+#error NitroModules cannot be found! Are you sure you installed NitroModules properly?
+#endif
+#if __has_include(<NitroModules/NitroDefines.hpp>)
+#include <NitroModules/NitroDefines.hpp>
+#else
+#error NitroModules cannot be found! Are you sure you installed NitroModules properly?
+#endif
+
+
+
+#include <optional>
+
+namespace margelo::nitro::realtimenitro {
+
+  /**
+   * A struct which can be represented as a JavaScript object (ReconnectPolicy).
+   */
+  struct ReconnectPolicy {
+  public:
+    std::optional<double> initialDelay     SWIFT_PRIVATE;
+    std::optional<double> maxDelay     SWIFT_PRIVATE;
+    std::optional<double> multiplier     SWIFT_PRIVATE;
+    std::optional<double> jitter     SWIFT_PRIVATE;
+    std::optional<double> maxAttempts     SWIFT_PRIVATE;
+    std::optional<double> stableAfter     SWIFT_PRIVATE;
+
+  public:
+    ReconnectPolicy() = default;
+    explicit ReconnectPolicy(std::optional<double> initialDelay, std::optional<double> maxDelay, std::optional<double> multiplier, std::optional<double> jitter, std::optional<double> maxAttempts, std::optional<double> stableAfter): initialDelay(initialDelay), maxDelay(maxDelay), multiplier(multiplier), jitter(jitter), maxAttempts(maxAttempts), stableAfter(stableAfter) {}
+  };
+
+} // namespace margelo::nitro::realtimenitro
+
+namespace margelo::nitro {
+
+  using namespace margelo::nitro::realtimenitro;
+
+  // C++ ReconnectPolicy <> JS ReconnectPolicy (object)
+  template <>
+  struct JSIConverter<ReconnectPolicy> final {
+    static inline ReconnectPolicy fromJSI(jsi::Runtime& runtime, const jsi::Value& arg) {
+      jsi::Object obj = arg.asObject(runtime);
+      return ReconnectPolicy(
+        JSIConverter<std::optional<double>>::fromJSI(runtime, obj.getProperty(runtime, "initialDelay")),
+        JSIConverter<std::optional<double>>::fromJSI(runtime, obj.getProperty(runtime, "maxDelay")),
+        JSIConverter<std::optional<double>>::fromJSI(runtime, obj.getProperty(runtime, "multiplier")),
+        JSIConverter<std::optional<double>>::fromJSI(runtime, obj.getProperty(runtime, "jitter")),
+        JSIConverter<std::optional<double>>::fromJSI(runtime, obj.getProperty(runtime, "maxAttempts")),
+        JSIConverter<std::optional<double>>::fromJSI(runtime, obj.getProperty(runtime, "stableAfter"))
+      );
+    }
+    static inline jsi::Value toJSI(jsi::Runtime& runtime, const ReconnectPolicy& arg) {
+      jsi::Object obj(runtime);
+      obj.setProperty(runtime, "initialDelay", JSIConverter<std::optional<double>>::toJSI(runtime, arg.initialDelay));
+      obj.setProperty(runtime, "maxDelay", JSIConverter<std::optional<double>>::toJSI(runtime, arg.maxDelay));
+      obj.setProperty(runtime, "multiplier", JSIConverter<std::optional<double>>::toJSI(runtime, arg.multiplier));
+      obj.setProperty(runtime, "jitter", JSIConverter<std::optional<double>>::toJSI(runtime, arg.jitter));
+      obj.setProperty(runtime, "maxAttempts", JSIConverter<std::optional<double>>::toJSI(runtime, arg.maxAttempts));
+      obj.setProperty(runtime, "stableAfter", JSIConverter<std::optional<double>>::toJSI(runtime, arg.stableAfter));
+      return obj;
+    }
+    static inline bool canConvert(jsi::Runtime& runtime, const jsi::Value& value) {
+      if (!value.isObject()) {
+        return false;
+      }
+      jsi::Object obj = value.getObject(runtime);
+      if (!JSIConverter<std::optional<double>>::canConvert(runtime, obj.getProperty(runtime, "initialDelay"))) return false;
+      if (!JSIConverter<std::optional<double>>::canConvert(runtime, obj.getProperty(runtime, "maxDelay"))) return false;
+      if (!JSIConverter<std::optional<double>>::canConvert(runtime, obj.getProperty(runtime, "multiplier"))) return false;
+      if (!JSIConverter<std::optional<double>>::canConvert(runtime, obj.getProperty(runtime, "jitter"))) return false;
+      if (!JSIConverter<std::optional<double>>::canConvert(runtime, obj.getProperty(runtime, "maxAttempts"))) return false;
+      if (!JSIConverter<std::optional<double>>::canConvert(runtime, obj.getProperty(runtime, "stableAfter"))) return false;
+      return true;
+    }
+  };
+
+} // namespace margelo::nitro
@@ -0,0 +1,79 @@
+///
+/// ServiceThreadOptions.hpp
+/// This file was generated by nitrogen. DO NOT MODIFY THIS FILE.
+/// https://github.com/mrousavy/nitro
+/// Copyright © 2026 Marc Rousavy @ Margelo
+///
+
+#pragma once
+
+#if __has_include(<NitroModules/JSIConverter.hpp>)
+#include <NitroModules/JSIConverter.hpp>
+#else
+#error NitroModules cannot be found! Are you sure you installed NitroModules properly?
+#endif
+#if __has_include(<NitroModules/NitroDefines.hpp>)
+#include <NitroModules/NitroDefines.hpp>
+#else
+#error NitroModules cannot be found! Are you sure you installed NitroModules properly?
+#endif
+
+
+
+#include <string>
+#include <optional>
+#include <vector>
+
+namespace margelo::nitro::realtimenitro {
+
+  /**
+   * A struct which can be represented as a JavaScript object (ServiceThreadOptions).
+   */
+  struct ServiceThreadOptions {
+  public:
+    std::optional<std::string> name     SWIFT_PRIVATE;
+    std::optional<double> nice     SWIFT_PRIVATE;
+    std::optional<std::vector<double>> cpuAffinity     SWIFT_PRIVATE;
+
+  public:
+    ServiceThreadOptions() = default;
+    explicit ServiceThreadOptions(std::optional<std::string> name, std::optional<double> nice, std::optional<std::vector<double>> cpuAffinity): name(name), nice(nice), cpuAffinity(cpuAffinity) {}
+  };
+
+} // namespace margelo::nitro::realtimenitro
+
+namespace margelo::nitro {
+
+  using namespace margelo::nitro::realtimenitro;
+
+  // C++ ServiceThreadOptions <> JS ServiceThreadOptions (object)
+  template <>
+  struct JSIConverter<ServiceThreadOptions> final {
+    static inline ServiceThreadOptions fromJSI(jsi::Runtime& runtime, const jsi::Value& arg) {
+      jsi::Object obj = arg.asObject(runtime);
+      return ServiceThreadOptions(
+        JSIConverter<std::optional<std::string>>::fromJSI(runtime, obj.getProperty(runtime, "name")),
+        JSIConverter<std::optional<double>>::fromJSI(runtime, obj.getProperty(runtime, "nice")),
+        JSIConverter<std::optional<std::vector<double>>>::fromJSI(runtime, obj.getProperty(runtime, "cpuAffinity"))
+      );
+    }
+    static inline jsi::Value toJSI(jsi::Runtime& runtime, const ServiceThreadOptions& arg) {
+      jsi::Object obj(runtime);
+      obj.setProperty(runtime, "name", JSIConverter<std::optional<std::string>>::toJSI(runtime, arg.name));
+      obj.setProperty(runtime, "nice", JSIConverter<std::optional<double>>::toJSI(runtime, arg.nice));
+      obj.setProperty(runtime, "cpuAffinity", JSIConverter<std::optional<std::vector<double>>>::toJSI(runtime, arg.cpuAffinity));
+      return obj;
+    }
+    static inline bool canConvert(jsi::Runtime& runtime, const jsi::Value& value) {
+      if (!value.isObject()) {
+        return false;
+      }
+      jsi::Object obj = value.getObject(runtime);
+      if (!JSIConverter<std::optional<std::string>>::canConvert(runtime, obj.getProperty(runtime, "name"))) return false;
+      if (!JSIConverter<std::optional<double>>::canConvert(runtime, obj.getProperty(runtime, "nice"))) return false;
+      if (!JSIConverter<std::optional<std::vector<double>>>::canConvert(runtime, obj.getProperty(runtime, "cpuAffinity"))) return false;
+      return true;
+    }
+  };
+
+} // namespace margelo::nitro
@@ -0,0 +1,97 @@
+///
+/// SocketOptions.hpp
+/// This file was generated by nitrogen. DO NOT MODIFY THIS FILE.
+/// https://github.com/mrousavy/nitro
+/// Copyright © 2026 Marc Rousavy @ Margelo
+///
+
+#pragma once
+
+#if __has_include(<NitroModules/JSIConverter.hpp>)
+#include <NitroModules/JSIConverter.hpp>
+#else
+#error NitroModules cannot be found! Are you sure you installed NitroModules properly?
+#endif
+#if __has_include(<NitroModules/NitroDefines.hpp>)
+#include <NitroModules/NitroDefines.hpp>
+#else
+#error NitroModules cannot be found! Are you sure you installed NitroModules properly?
+#endif
+
+
+
+#include <optional>
+
+namespace margelo::nitro::realtimenitro {
+
+  /**
+   * A struct which can be represented as a JavaScript object (SocketOptions).
+   */
+  struct SocketOptions {
+  public:
+    std::optional<bool> noDelay     SWIFT_PRIVATE;
+    std::optional<double> sendBufferSize     SWIFT_PRIVATE;
+    std::optional<double> receiveBufferSize     SWIFT_PRIVATE;
+    std::optional<bool> keepAlive     SWIFT_PRIVATE;
+    std::optional<double> keepAliveIdle     SWIFT_PRIVATE;
+    std::optional<double> keepAliveInterval     SWIFT_PRIVATE;
+    std::optional<double> keepAliveCount     SWIFT_PRIVATE;
+    std::optional<double> userTimeout     SWIFT_PRIVATE;
+
+  public:
+    SocketOptions() = default;
+    explicit SocketOptions(std::optional<bool> noDelay, std::optional<double> sendBufferSize, std::optional<double> receiveBufferSize, std::optional<bool> keepAlive, std::optional<double> keepAliveIdle, std::optional<double> keepAliveInterval, std::optional<double> keepAliveCount, std::optional<double> userTimeout): noDelay(noDelay), sendBufferSize(sendBufferSize), receiveBufferSize(receiveBufferSize), keepAlive(keepAlive), keepAliveIdle(keepAliveIdle), keepAliveInterval(keepAliveInterval), keepAliveCount(keepAliveCount), userTimeout(userTimeout) {}
+  };
+
+} // namespace margelo::nitro::realtimenitro
+
+namespace margelo::nitro {
+
+  using namespace margelo::nitro::realtimenitro;
+
+  // C++ SocketOptions <> JS SocketOptions (object)
+  template <>
+  struct JSIConverter<SocketOptions> final {
+    static inline SocketOptions fromJSI(jsi::Runtime& runtime, const jsi::Value& arg) {
+      jsi::Object obj = arg.asObject(runtime);
+      return SocketOptions(
+        JSIConverter<std::optional<bool>>::fromJSI(runtime, obj.getProperty(runtime, "noDelay")),
+        JSIConverter<std::optional<double>>::fromJSI(runtime, obj.getProperty(runtime, "sendBufferSize")),
+        JSIConverter<std::optional<double>>::fromJSI(runtime, obj.getProperty(runtime, "receiveBufferSize")),
+        JSIConverter<std::optional<bool>>::fromJSI(runtime, obj.getProperty(runtime, "keepAlive")),
+        JSIConverter<std::optional<double>>::fromJSI(runtime, obj.getProperty(runtime, "keepAliveIdle")),
+        JSIConverter<std::optional<double>>::fromJSI(runtime, obj.getProperty(runtime, "keepAliveInterval")),
+        JSIConverter<std::optional<double>>::fromJSI(runtime, obj.getProperty(runtime, "keepAliveCount")),
+        JSIConverter<std::optional<double>>::fromJSI(runtime, obj.getProperty(runtime, "userTimeout"))
+      );
+    }
+    static inline jsi::Value toJSI(jsi::Runtime& runtime, const SocketOptions& arg) {
+      jsi::Object obj(runtime);
+      obj.setProperty(runtime, "noDelay", JSIConverter<std::optional<bool>>::toJSI(runtime, arg.noDelay));
+      obj.setProperty(runtime, "sendBufferSize", JSIConverter<std::optional<double>>::toJSI(runtime, arg.sendBufferSize));
+      obj.setProperty(runtime, "receiveBufferSize", JSIConverter<std::optional<double>>::toJSI(runtime, arg.receiveBufferSize));
+      obj.setProperty(runtime, "keepAlive", JSIConverter<std::optional<bool>>::toJSI(runtime, arg.keepAlive));
+      obj.setProperty(runtime, "keepAliveIdle", JSIConverter<std::optional<double>>::toJSI(runtime, arg.keepAliveIdle));
+      obj.setProperty(runtime, "keepAliveInterval", JSIConverter<std::optional<double>>::toJSI(runtime, arg.keepAliveInterval));
+      obj.setProperty(runtime, "keepAliveCount", JSIConverter<std::optional<double>>::toJSI(runtime, arg.keepAliveCount));
+      obj.setProperty(runtime, "userTimeout", JSIConverter<std::optional<double>>::toJSI(runtime, arg.userTimeout));
+      return obj;
+    }
+    static inline bool canConvert(jsi::Runtime& runtime, const jsi::Value& value) {
+      if (!value.isObject()) {
+        return false;
+      }
+      jsi::Object obj = value.getObject(runtime);
+      if (!JSIConverter<std::optional<bool>>::canConvert(runtime, obj.getProperty(runtime, "noDelay"))) return false;
+      if (!JSIConverter<std::optional<double>>::canConvert(runtime, obj.getProperty(runtime, "sendBufferSize"))) return false;
+      if (!JSIConverter<std::optional<double>>::canConvert(runtime, obj.getProperty(runtime, "receiveBufferSize"))) return false;
+      if (!JSIConverter<std::optional<bool>>::canConvert(runtime, obj.getProperty(runtime, "keepAlive"))) return false;
+      if (!JSIConverter<std::optional<double>>::canConvert(runtime, obj.getProperty(runtime, "keepAliveIdle"))) return false;
+      if (!JSIConverter<std::optional<double>>::canConvert(runtime, obj.getProperty(runtime, "keepAliveInterval"))) return false;
+      if (!JSIConverter<std::optional<double>>::canConvert(runtime, obj.getProperty(runtime, "keepAliveCount"))) return false;
+      if (!JSIConverter<std::optional<double>>::canConvert(runtime, obj.getProperty(runtime, "userTimeout"))) return false;
+      return true;
+    }
+  };
+
+} // namespace margelo::nitro
@@ -0,0 +1,102 @@
+///
+/// WebSocketOptions.hpp
+/// This file was generated by nitrogen. DO NOT MODIFY THIS FILE.
+/// https://github.com/mrousavy/nitro
+/// Copyright © 2026 Marc Rousavy @ Margelo
+///
+
+#pragma once
+
+#if __has_include(<NitroModules/JSIConverter.hpp>)
+#include <NitroModules/JSIConverter.hpp>
+#else
+#error NitroModules cannot be found! Are you sure you installed NitroModules properly?
+#endif
+#if __has_include(<NitroModules/NitroDefines.hpp>)
+#include <NitroModules/NitroDefines.hpp>
+#else
+#error NitroModules cannot be found! Are you sure you installed NitroModules properly?
+#endif
+
+// Forward declaration of `SocketOptions` to properly resolve imports.
+namespace margelo::nitro::realtimenitro { struct SocketOptions; }
+
+#include <string>
+#include <vector>
+#include <optional>
+#include <unordered_map>
+#include "SocketOptions.hpp"
+
+namespace margelo::nitro::realtimenitro {
+
+  /**
+   * A struct which can be represented as a JavaScript object (WebSocketOptions).
+   */
+  struct WebSocketOptions {
+  public:
+    std::optional<std::vector<std::string>> protocols     SWIFT_PRIVATE;
+    std::optional<std::unordered_map<std::string, std::string>> headers     SWIFT_PRIVATE;
+    std::optional<double> timeout     SWIFT_PRIVATE;
+    std::optional<bool> happyEyeballs     SWIFT_PRIVATE;
+    std::optional<std::vector<std::string>> endpoints     SWIFT_PRIVATE;
+    std::optional<std::string> endpointStrategy     SWIFT_PRIVATE;
+    std::optional<double> failoverDelay     SWIFT_PRIVATE;
+    std::optional<SocketOptions> socket     SWIFT_PRIVATE;
+
+  public:
+    WebSocketOptions() = default;
+    explicit WebSocketOptions(std::optional<std::vector<std::string>> protocols, std::optional<std::unordered_map<std::string, std::string>> headers, std::optional<double> timeout, std::optional<bool> happyEyeballs, std::optional<std::vector<std::string>> endpoints, std::optional<std::string> endpointStrategy, std::optional<double> failoverDelay, std::optional<SocketOptions> socket): protocols(protocols), headers(headers), timeout(timeout), happyEyeballs(happyEyeballs), endpoints(endpoints), endpointStrategy(endpointStrategy), failoverDelay(failoverDelay), socket(socket) {}
+  };
+
+} // namespace margelo::nitro::realtimenitro
+
+namespace margelo::nitro {
+
+  using namespace margelo::nitro::realtimenitro;
+
+  // C++ WebSocketOptions <> JS WebSocketOptions (object)
+  template <>
+  struct JSIConverter<WebSocketOptions> final {
+    static inline WebSocketOptions fromJSI(jsi::Runtime& runtime, const jsi::Value& arg) {
+      jsi::Object obj = arg.asObject(runtime);
+      return WebSocketOptions(
+        JSIConverter<std::optional<std::vector<std::string>>>::fromJSI(runtime, obj.getProperty(runtime, "protocols")),
+        JSIConverter<std::optional<std::unordered_map<std::string, std::string>>>::fromJSI(runtime, obj.getProperty(runtime, "headers")),
+        JSIConverter<std::optional<double>>::fromJSI(runtime, obj.getProperty(runtime, "timeout")),
+        JSIConverter<std::optional<bool>>::fromJSI(runtime, obj.getProperty(runtime, "happyEyeballs")),
+        JSIConverter<std::optional<std::vector<std::string>>>::fromJSI(runtime, obj.getProperty(runtime, "endpoints")),
+        JSIConverter<std::optional<std::string>>::fromJSI(runtime, obj.getProperty(runtime, "endpointStrategy")),
+        JSIConverter<std::optional<double>>::fromJSI(runtime, obj.getProperty(runtime, "failoverDelay")),
+        JSIConverter<std::optional<SocketOptions>>::fromJSI(runtime, obj.getProperty(runtime, "socket"))
+      );
+    }
+    static inline jsi::Value toJSI(jsi::Runtime& runtime, const WebSocketOptions& arg) {
+      jsi::Object obj(runtime);
+      obj.setProperty(runtime, "protocols", JSIConverter<std::optional<std::vector<std::string>>>::toJSI(runtime, arg.protocols));
+      obj.setProperty(runtime, "headers", JSIConverter<std::optional<std::unordered_map<std::string, std::string>>>::toJSI(runtime, arg.headers));
+      obj.setProperty(runtime, "timeout", JSIConverter<std::optional<double>>::toJSI(runtime, arg.timeout));
+      obj.setProperty(runtime, "happyEyeballs", JSIConverter<std::optional<bool>>::toJSI(runtime, arg.happyEyeballs));
+      obj.setProperty(runtime, "endpoints", JSIConverter<std::optional<std::vector<std::string>>>::toJSI(runtime, arg.endpoints));
+      obj.setProperty(runtime, "endpointStrategy", JSIConverter<std::optional<std::string>>::toJSI(runtime, arg.endpointStrategy));
+      obj.setProperty(runtime, "failoverDelay", JSIConverter<std::optional<double>>::toJSI(runtime, arg.failoverDelay));
+      obj.setProperty(runtime, "socket", JSIConverter<std::optional<SocketOptions>>::toJSI(runtime, arg.socket));
+      return obj;
+    }
+    static inline bool canConvert(jsi::Runtime& runtime, const jsi::Value& value) {
+      if (!value.isObject()) {
+        return false;
+      }
+      jsi::Object obj = value.getObject(runtime);
+      if (!JSIConverter<std::optional<std::vector<std::string>>>::canConvert(runtime, obj.getProperty(runtime, "protocols"))) return false;
+      if (!JSIConverter<std::optional<std::unordered_map<std::string, std::string>>>::canConvert(runtime, obj.getProperty(runtime, "headers"))) return false;
+      if (!JSIConverter<std::optional<double>>::canConvert(runtime, obj.getProperty(runtime, "timeout"))) return false;
+      if (!JSIConverter<std::optional<bool>>::canConvert(runtime, obj.getProperty(runtime, "happyEyeballs"))) return false;
+      if (!JSIConverter<std::optional<std::vector<std::string>>>::canConvert(runtime, obj.getProperty(runtime, "endpoints"))) return false;
+      if (!JSIConverter<std::optional<std::string>>::canConvert(runtime, obj.getProperty(runtime, "endpointStrategy"))) return false;
+      if (!JSIConverter<std::optional<double>>::canConvert(runtime, obj.getProperty(runtime, "failoverDelay"))) return false;
+      if (!JSIConverter<std::optional<SocketOptions>>::canConvert(runtime, obj.getProperty(runtime, "socket"))) return false;
+      return true;
+    }
+  };
+
+} // namespace margelo::nitro
@@ -0,0 +1,80 @@
+import type { WebSocket } from './specs/WebSocket.nitro'
+
+const HEADER_SIZE = 64
+const WRAP_MARKER = 0xffffffff
+const FLAG_BINARY = 1
+
+/**
+ * Consumer for the shared receive ring (see `WebSocket.enableReceiveRing`)
+ *
+ * @example
+ * ```typescript
+ * const reader = new ReceiveRingReader(ws, ws.enableReceiveRing(1 << 20))
+ *
+ * const onFrame = () => {
+ *   reader.drain((data, isBinary) => handle(data, isBinary))
+ *   requestAnimationFrame(onFrame)
+ * }
+ * requestAnimationFrame(onFrame)
+ * ```
+ */
+export class ReceiveRingReader {
+  private readonly view: DataView
+  private readonly bytes: Uint8Array
+  private readonly capacity: number
+  private tail = 0
+
+  constructor(
+    private readonly ws: WebSocket,
+    ring: ArrayBuffer
+  ) {
+    this.view = new DataView(ring)
+    this.bytes = new Uint8Array(ring, HEADER_SIZE)
+    this.capacity = this.view.getUint32(8, true)
+  }
+
+  /**
+   * Frames dropped because the consumer fell behind
+   */
+  get dropped(): number {
+    return this.view.getUint32(12, true)
+  }
+
+  /**
+   * Invoke `onRecord` for every frame received since the last call
+   *
+   * `data` is a view into the ring and stays valid until the next
+   * `drain()`; copy it if you need it longer.
+   *
+   * @returns Number of frames delivered
+   */
+  drain(onRecord: (data: Uint8Array, isBinary: boolean) => void): number {
+    // Releases the records handed out by the previous drain()
+    const head = this.ws.syncReceiveRing(this.tail)
+    let tail = this.tail
+    let count = 0
+
+    while (tail !== head) {
+      const length = this.view.getUint32(HEADER_SIZE + tail, true)
+      if (length === WRAP_MARKER) {
+        tail = 0
+        continue
+      }
+      const flags = this.view.getUint32(HEADER_SIZE + tail + 4, true)
+      const start = tail + 8
+      onRecord(
+        this.bytes.subarray(start, start + length),
+        (flags & FLAG_BINARY) !== 0
+      )
+      count++
+
+      tail = start + ((length + 7) & ~7)
+      if (tail === this.capacity) {
+        tail = 0
+      }
+    }
+
+    this.tail = tail
+    return count
+  }
+}
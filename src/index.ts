@@ -28,3 +28,9 @@ export function createWebSocket(): WebSocket {
 export type { WebSocket } from './specs/WebSocket.nitro'
 export { WebSocketState } from './specs/WebSocket.nitro'
 export type { WebSocketOptions } from './specs/WebSocket.nitro'
+export type { ServiceThreadOptions } from './specs/WebSocket.nitro'
+export type { CloseOptions } from './specs/WebSocket.nitro'
+export type { ReconnectPolicy } from './specs/WebSocket.nitro'
+export type { KeepalivePolicy } from './specs/WebSocket.nitro'
+export type { SocketOptions } from './specs/WebSocket.nitro'
+export { ReceiveRingReader } from './ReceiveRingReader'
@@ -1,4 +1,4 @@
-import { type HybridObject } from 'react-native-nitro-modules'
+import { type AnyMap, type HybridObject } from 'react-native-nitro-modules'
 
 /**
  * WebSocket connection states
@@ -25,9 +25,203 @@ export interface WebSocketOptions {
   headers?: Record<string, string>
 
   /**
-   * Timeout for connection in milliseconds
+   * Connect deadline in milliseconds, covering DNS, TCP, TLS and the
+   * WebSocket handshake (default: none beyond the native 20 s timeout)
    */
   timeout?: number
+
+  /**
+   * Race IPv6 and IPv4 for dual-stack hosts (RFC 8305 "Happy Eyeballs"):
+   * IPv4 starts 250 ms after IPv6, or as soon as IPv6 fails, and the first
+   * connection to complete the handshake is kept (default: true)
+   */
+  happyEyeballs?: boolean
+
+  /**
+   * Fallback URLs for the same service, tried after the `url` passed to
+   * `connect()`. Reconnects use the same list
+   */
+  endpoints?: string[]
+
+  /**
+   * How to pick among `url` and `endpoints` (default: `'priority'`)
+   *
+   * - `'priority'` - in order; the next one starts after `failoverDelay`
+   *   without a handshake, or at once when every attempt so far failed
+   * - `'latency'` - like `'priority'`, ordered by remembered handshake
+   *   time (see `getEndpointLatencies`); unmeasured endpoints go after
+   *   measured ones but ahead of endpoints that recently failed
+   * - `'race'` - all at once; the first handshake wins
+   */
+  endpointStrategy?: string
+
+  /**
+   * Head start in milliseconds for each endpoint before the next one
+   * joins (default: 2000)
+   */
+  failoverDelay?: number
+
+  /**
+   * TCP options applied to every connection attempt before it connects
+   */
+  socket?: SocketOptions
+}
+
+/**
+ * TCP socket tuning (see `WebSocketOptions.socket`). Unset fields keep the
+ * OS default
+ */
+export interface SocketOptions {
+  /**
+   * Disable Nagle's algorithm (TCP_NODELAY) so small frames go out at once
+   * (default: true)
+   */
+  noDelay?: boolean
+
+  /**
+   * Kernel send buffer in bytes (SO_SNDBUF)
+   */
+  sendBufferSize?: number
+
+  /**
+   * Kernel receive buffer in bytes (SO_RCVBUF)
+   */
+  receiveBufferSize?: number
+
+  /**
+   * Enable TCP keep-alive probes (SO_KEEPALIVE). Independent of WebSocket
+   * pings; lets the OS detect dead peers without waking the app (default:
+   * true when any other `keepAlive*` field is set)
+   */
+  keepAlive?: boolean
+
+  /**
+   * Idle time in milliseconds before the first probe (TCP_KEEPIDLE,
+   * TCP_KEEPALIVE on Apple). Rounded up to whole seconds
+   */
+  keepAliveIdle?: number
+
+  /**
+   * Time in milliseconds between probes (TCP_KEEPINTVL). Rounded up to
+   * whole seconds
+   */
+  keepAliveInterval?: number
+
+  /**
+   * Unanswered probes before the connection drops (TCP_KEEPCNT)
+   */
+  keepAliveCount?: number
+
+  /**
+   * Drop the connection when sent data stays unacknowledged this many
+   * milliseconds (TCP_USER_TIMEOUT; TCP_RXT_CONNDROPTIME on Apple,
+   * rounded up to whole seconds)
+   */
+  userTimeout?: number
+}
+
+/**
+ * Closing behaviour (see `WebSocket.setCloseOptions`)
+ */
+export interface CloseOptions {
+  /**
+   * Write messages queued before `close()` ahead of the close frame
+   * (default: true)
+   */
+  drain?: boolean
+
+  /**
+   * Deadline in milliseconds for the whole closing phase: draining, the
+   * close frame and the peer's close reply. The connection is dropped
+   * when it expires (default: 5000)
+   */
+  timeout?: number
+}
+
+/**
+ * Native automatic reconnect (see `WebSocket.setReconnectPolicy`)
+ *
+ * The delay before attempt n (1-based) is
+ * `min(maxDelay, initialDelay * multiplier^(n-1))`, randomised by ±`jitter`.
+ */
+export interface ReconnectPolicy {
+  /**
+   * Delay before the first attempt in milliseconds (default: 500)
+   */
+  initialDelay?: number
+
+  /**
+   * Upper bound for the delay in milliseconds (default: 30000)
+   */
+  maxDelay?: number
+
+  /**
+   * Backoff factor per attempt, >= 1 (default: 2)
+   */
+  multiplier?: number
+
+  /**
+   * Random spread as a fraction of the delay, 0..1 (default: 0.2)
+   */
+  jitter?: number
+
+  /**
+   * Attempts before giving up, 0 for unlimited (default: 0)
+   */
+  maxAttempts?: number
+
+  /**
+   * A connection open at least this long (ms) resets the backoff
+   * (default: 5000)
+   */
+  stableAfter?: number
+}
+
+/**
+ * Adaptive keep-alive (see `WebSocket.setAdaptiveKeepalive`)
+ */
+export interface KeepalivePolicy {
+  /**
+   * Shortest ping interval in milliseconds (default: 10000)
+   */
+  minInterval?: number
+
+  /**
+   * Longest ping interval in milliseconds (default: 240000)
+   */
+  maxInterval?: number
+
+  /**
+   * Identifies the current network, e.g. Wi-Fi SSID or carrier from a
+   * connectivity module. Intervals are learned per network and endpoint
+   * (default: `''`, one network)
+   */
+  networkKey?: string
+}
+
+/**
+ * Scheduling options for the native I/O thread
+ */
+export interface ServiceThreadOptions {
+  /**
+   * Thread name shown in debuggers and traces (Linux/Android: max 15 chars)
+   */
+  name?: string
+
+  /**
+   * Nice value, -20 (highest priority) to 19 (lowest)
+   *
+   * On iOS/macOS this maps to a QoS class: <= -10 user-interactive,
+   * < 0 user-initiated, 0 default, > 0 utility, >= 10 background.
+   * Negative values may require privileges on Linux.
+   */
+  nice?: number
+
+  /**
+   * CPU indices the thread may run on (Linux/Android only, ignored elsewhere).
+   * Must be whole numbers below the platform's CPU_SETSIZE
+   */
+  cpuAffinity?: number[]
 }
 
 /**
@@ -53,10 +247,16 @@ export interface WebSocket extends HybridObject<{
    *
    * @param url - WebSocket URL (ws:// or wss://)
    * @param protocols - Optional sub-protocols
-   * @returns Promise that resolves when connected
+   * @param options - Handshake headers, sub-protocols and connect timeout
+   * @returns Promise that resolves when the handshake completes and rejects
+   *          on connection error, timeout, or a newer connect()/destroy
    * @throws Error if URL is invalid or connection fails
    */
-  connect(url: string, protocols?: string[]): Promise<void>
+  connect(
+    url: string,
+    protocols?: string[],
+    options?: WebSocketOptions
+  ): Promise<void>
 
   /**
    * Send a text message
@@ -74,14 +274,69 @@ export interface WebSocket extends HybridObject<{
    */
   sendBinary(data: ArrayBuffer): void
 
+  /**
+   * Send an object as a MessagePack-encoded binary frame
+   *
+   * Encoding happens natively on the I/O thread.
+   *
+   * @param value - Object to encode
+   * @throws Error if not connected
+   */
+  sendMsgPack(value: AnyMap): void
+
+  /**
+   * Send an object as a CBOR-encoded binary frame
+   *
+   * Encoding happens natively on the I/O thread.
+   *
+   * @param value - Object to encode
+   * @throws Error if not connected
+   */
+  sendCbor(value: AnyMap): void
+
   /**
    * Close the WebSocket connection
    *
+   * Messages sent before `close()` are written first (see
+   * `setCloseOptions`), then the close frame is sent and the socket waits
+   * for the peer's reply up to the close deadline. `onClose` fires once
+   * the connection is gone.
+   *
    * @param code - Close code (default: 1000 - Normal Closure)
    * @param reason - Close reason string
    */
   close(code?: number, reason?: string): void
 
+  /**
+   * Configure the closing phase for subsequent `close()` calls
+   *
+   * @param options - Drain and deadline settings
+   * @throws Error if `timeout` is not positive
+   */
+  setCloseOptions(options: CloseOptions): void
+
+  /**
+   * Reconnect natively when the connection drops or fails to open
+   *
+   * Applies to drops and failed attempts not caused by `close()` or a new
+   * `connect()`. While waiting for the next attempt the state is
+   * CONNECTING and `onReconnect` is called; `onOpen` fires again once an
+   * attempt succeeds. The promise of the original `connect()` still
+   * settles with its first attempt.
+   *
+   * @param policy - Backoff settings, or undefined to disable
+   * @throws Error for out-of-range values
+   */
+  setReconnectPolicy(policy?: ReconnectPolicy): void
+
+  /**
+   * Messages sent natively right after every handshake (e.g. auth and
+   * subscriptions), ahead of anything queued by `send()`
+   *
+   * @param messages - Text messages in send order (empty to clear)
+   */
+  setOpenMessages(messages: string[]): void
+
   /**
    * Get current connection state
    */
@@ -92,6 +347,12 @@ export interface WebSocket extends HybridObject<{
    */
   readonly url: string
 
+  /**
+   * URL of the endpoint the current connection went to (one of `url` and
+   * `WebSocketOptions.endpoints`); empty until connected
+   */
+  readonly endpoint: string
+
   /**
    * Callback when connection opens
    */
@@ -111,6 +372,27 @@ export interface WebSocket extends HybridObject<{
    */
   onBinaryMessage?: (data: ArrayBuffer) => void
 
+  /**
+   * Callback when a MessagePack binary frame is received
+   *
+   * When set, binary frames are decoded natively on the I/O thread and
+   * delivered here instead of `onBinaryMessage`. Frames that fail to
+   * decode are reported via `onError` and fall back to `onBinaryMessage`.
+   *
+   * @param value - Decoded top-level map
+   */
+  onMsgPackMessage?: (value: AnyMap) => void
+
+  /**
+   * Callback when a CBOR binary frame is received
+   *
+   * Same semantics as `onMsgPackMessage`; ignored while
+   * `onMsgPackMessage` is set.
+   *
+   * @param value - Decoded top-level map
+   */
+  onCborMessage?: (value: AnyMap) => void
+
   /**
    * Callback when an error occurs
    *
@@ -121,11 +403,21 @@ export interface WebSocket extends HybridObject<{
   /**
    * Callback when connection closes
    *
-   * @param code - Close code
+   * @param code - Close code from the peer's close frame, the code passed
+   *               to `close()` if the peer echoed it without one, or 1006
+   *               if the connection dropped without a close handshake
    * @param reason - Close reason
    */
   onClose?: (code: number, reason: string) => void
 
+  /**
+   * Callback when a native reconnect attempt is scheduled
+   *
+   * @param attempt - Attempt number since the last stable connection (1-based)
+   * @param delayMs - Time until the attempt starts
+   */
+  onReconnect?: (attempt: number, delayMs: number) => void
+
   /**
    * Set ping interval for keep-alive
    *
@@ -133,6 +425,60 @@ export interface WebSocket extends HybridObject<{
    */
   setPingInterval(intervalMs: number): void
 
+  /**
+   * Declare the connection dead when a ping gets no pong in time
+   *
+   * Catches half-open connections (e.g. after a mobile network switch)
+   * within one ping interval plus `timeoutMs`, instead of at the TCP
+   * timeout. The connection is dropped without a close handshake:
+   * `onClose` reports 1006 and the reconnect policy applies.
+   *
+   * @param timeoutMs - Deadline in milliseconds (0 to disable, the default)
+   */
+  setPongTimeout(timeoutMs: number): void
+
+  /**
+   * Keep-alive round trips
+   *
+   * - `pingsSent` / `pongsReceived` / `pongTimeouts`
+   * - `samples` - RTT samples in the window (last 64 pongs)
+   * - `intervalMs` - current ping interval (see `setAdaptiveKeepalive`)
+   * - `lastRttMs` / `minRttMs` / `avgRttMs` / `p99RttMs` - over the
+   *   window; absent until the first pong
+   */
+  getPingStats(): Record<string, number>
+
+  /**
+   * Learn the longest safe ping interval instead of using a fixed one
+   *
+   * The interval starts from the value learned for this network and
+   * endpoint, or from `setPingInterval` clamped to the policy. It grows by
+   * half after 3 pongs to pings sent after a whole interval with no
+   * messages either way, and never past 90% of an interval that failed
+   * before. A connection lost after going silent for a whole
+   * interval, or to the pong deadline, counts as an idle failure. The
+   * interval then falls back to the last one that worked, or halves if
+   * that one failed too. Learned values are shared by all sockets in the
+   * process.
+   *
+   * @param policy - Bounds and network key, or undefined for a fixed interval
+   * @throws Error if 0 < minInterval <= maxInterval does not hold
+   */
+  setAdaptiveKeepalive(policy?: KeepalivePolicy): void
+
+  /**
+   * Learned ping intervals in milliseconds, keyed by
+   * `'<networkKey>|<host>:<port>'`. Persist this to start from the learned
+   * values after an app restart
+   */
+  getKeepaliveIntervals(): Record<string, number>
+
+  /**
+   * Seed learned ping intervals, e.g. from a previous session's
+   * `getKeepaliveIntervals()` (merged, process-wide)
+   */
+  setKeepaliveIntervals(intervals: Record<string, number>): void
+
   /**
    * Set CA certificate file path for SSL/TLS verification
    *
@@ -140,4 +486,285 @@ export interface WebSocket extends HybridObject<{
    *              Pass empty string to disable certificate verification
    */
   setCAPath(path: string): void
+
+  /**
+   * Set the receive buffer size for this connection
+   *
+   * This is how many bytes are read per native receive callback. Small
+   * control sockets can save memory; bulk sockets read more per wakeup.
+   * Applies to the next `connect()`.
+   *
+   * @param bytes - Buffer size (default: 65536, clamped to 1 KB..16 MB)
+   * @throws Error if called while connected
+   */
+  setReceiveBufferSize(bytes: number): void
+
+  /**
+   * Set the maximum size of a reassembled message
+   *
+   * Larger messages are reported via `onError` and the connection is
+   * closed with code 1009 (Message Too Big).
+   *
+   * @param bytes - Max message size (0 = unlimited, the default)
+   */
+  setMaxMessageSize(bytes: number): void
+
+  /**
+   * Queue sends made while the socket is still CONNECTING
+   *
+   * Queued messages are written in the same native pass that completes
+   * the handshake, before `onOpen` runs, so a subscription burst does not
+   * wait for a round trip through JS. `state` is CONNECTING as soon as
+   * `connect()` returns, so you can send right after calling it.
+   *
+   * @param enabled - Queue instead of throwing (default: false)
+   */
+  setQueueWhileConnecting(enabled: boolean): void
+
+  /**
+   * Enable the native state store
+   *
+   * Text frames shaped like `{ key, snapshot }` or `{ key, patch }` are
+   * applied natively on the I/O thread and are NOT delivered to `onMessage`.
+   * `key` must be a string and `patch` an array (JSON Patch) or object
+   * (Merge Patch); frames that don't match go to `onMessage` as usual.
+   *
+   * @param patchFormat - `'json-patch'` (RFC 6902) or `'merge-patch'` (RFC 7386)
+   * @throws Error for unknown formats
+   */
+  enableStateStore(patchFormat: string): void
+
+  /**
+   * Disable the state store and drop all documents
+   */
+  disableStateStore(): void
+
+  /**
+   * Get an immutable JSON snapshot of a document
+   *
+   * @param key - Document key ('' for envelopes without a key)
+   * @returns Serialized JSON, or undefined if the document does not exist
+   */
+  getStateSnapshot(key: string): string | undefined
+
+  /**
+   * Get a document's version (increments per applied snapshot/patch)
+   *
+   * Cheap to poll: only re-read the snapshot when this changes.
+   *
+   * @param key - Document key
+   * @returns Version, or 0 if the document does not exist
+   */
+  getStateVersion(key: string): number
+
+  /**
+   * Take the JSON Pointers changed since the last call
+   *
+   * `''` means the whole document changed.
+   *
+   * @param key - Document key
+   */
+  takeStateChanges(key: string): string[]
+
+  /**
+   * Switch receiving to a shared ring buffer
+   *
+   * Received text and binary frames are appended natively into one
+   * long-lived ArrayBuffer instead of invoking `onMessage` /
+   * `onBinaryMessage` per frame. Poll it with `ReceiveRingReader`.
+   * When the consumer falls behind, new frames are dropped and counted.
+   *
+   * @param capacityBytes - Size of the data area (clamped to 4 KB..1 GB)
+   * @returns The ring (64-byte header followed by the data area)
+   * @throws Error if capacityBytes is not in 1..4294967295
+   */
+  enableReceiveRing(capacityBytes: number): ArrayBuffer
+
+  /**
+   * Return to per-message callbacks
+   */
+  disableReceiveRing(): void
+
+  /**
+   * Publish the consumer's read offset and get the producer's write offset
+   *
+   * Provides the memory ordering plain DataView reads cannot.
+   * Normally called through `ReceiveRingReader.drain()`.
+   *
+   * @param consumedTail - Offset up to which records were consumed
+   * @returns Current head offset
+   * @throws Error if the ring is not enabled or consumedTail is not a u32
+   */
+  syncReceiveRing(consumedTail: number): number
+
+  /**
+   * Open a logical channel multiplexed over this socket
+   *
+   * Channel messages travel as binary frames with a 4-byte header
+   * (magic `0xCE`, type, 16-bit channel id), so the server must speak the
+   * same framing; an echo server works as is. Each channel has its own
+   * callbacks, send queue and credit-based flow control: a slow channel
+   * stalls only itself, and queued channels are written round-robin.
+   * Channels stay open across reconnects. Other messages still reach
+   * `onMessage` / `onBinaryMessage`.
+   *
+   * @param id - Channel id (0-65535)
+   * @param onMessage - Text messages on this channel
+   * @param onBinaryMessage - Binary messages on this channel
+   * @param window - Receive window in bytes (65536..16777216, default 65536)
+   * @throws Error if the channel is already open or an argument is out of range
+   */
+  openChannel(
+    id: number,
+    onMessage: (message: string) => void,
+    onBinaryMessage?: (data: ArrayBuffer) => void,
+    window?: number
+  ): void
+
+  /**
+   * Close a channel and drop its queued messages
+   */
+  closeChannel(id: number): void
+
+  /**
+   * Queue a text message on a channel
+   *
+   * @returns false if the channel is not open, the message is larger than
+   *   64 KB, or the channel already queues 8 MB
+   */
+  sendChannel(id: number, message: string): boolean
+
+  /**
+   * Queue a binary message on a channel (see `sendChannel`)
+   */
+  sendChannelBinary(id: number, data: ArrayBuffer): boolean
+
+  /**
+   * Counters for one channel (empty if it is not open)
+   *
+   * - `messagesSent` / `messagesReceived`
+   * - `queuedBytes` - waiting for credit or their turn
+   * - `sendCredit` - bytes the peer currently accepts
+   * - `creditWaits` - send turns skipped for lack of credit
+   * - `dropped` - received messages beyond the granted window
+   */
+  getChannelStats(id: number): Record<string, number>
+
+  /**
+   * Counters for the native event loops (all sockets in the process)
+   *
+   * - `loops` - number of event loops in the pool
+   * - `servicePasses` - times the loop woke up and serviced sockets/timers
+   * - `wakeups` - cross-thread wakeups requested by `send()`/`close()`/etc.
+   * - `tasks` - cross-thread tasks executed on the loop
+   *
+   * Sample twice and diff to get rates; an idle process should show
+   * `servicePasses` advancing only for keep-alive pings.
+   */
+  getEventLoopStats(): Record<string, number>
+
+  /**
+   * Configure scheduling of the shared native I/O thread
+   *
+   * Applies to the process-wide event loop (all sockets), immediately if
+   * it is already running, otherwise when it starts on the first `connect()`.
+   *
+   * @param options - Thread name, nice value and CPU affinity
+   * @throws Error if `nice` or a CPU index is out of range
+   */
+  setServiceThreadOptions(options: ServiceThreadOptions): void
+
+  /**
+   * Shard connections across several native event loops
+   *
+   * Each loop has its own I/O thread and owns its sockets outright, so
+   * loops never contend on locks. Useful for processes holding dozens of
+   * busy connections; a single loop is best for typical apps.
+   *
+   * Must be called before the first `connect()` in the process.
+   *
+   * @param count - Number of loops (1..64, default: 1)
+   * @param assignment - `'least-load'` (fewest open connections, default)
+   *                     or `'hash'` (stable loop per URL)
+   * @throws Error for invalid arguments, or to resize a running pool
+   */
+  configureEventLoops(count: number, assignment: string): void
+
+  /**
+   * Connection setup stats for this socket
+   *
+   * - `connects` - successful handshakes (including reconnects)
+   * - `lastConnectMs` - time from `connect()` to handshake complete
+   * - `tlsReused` - 1 if the last connect reused cached TLS state and CA
+   *   store, 0 if it had to create them
+   * - `reconnects` - attempts scheduled by the reconnect policy
+   * - `tlsHandshakes` / `tlsResumed` - TLS handshakes, and those that
+   *   resumed a cached session
+   * - `tlsResumeRate` - `tlsResumed / tlsHandshakes`
+   * - `raceFallbacks` - connects won by a later attempt (IPv4 in the
+   *   Happy Eyeballs race, or a fallback endpoint)
+   * - `warmAdopted` - connects served by `preconnect()`
+   */
+  getConnectStats(): Record<string, number>
+
+  /**
+   * Resolve `host` ahead of `connect()` (process-wide)
+   *
+   * Lookups use the system resolver (so VPN / Private DNS and the hosts
+   * file apply) on a background thread, and answers are cached for 60 s.
+   * A connect or reconnect to a cached host skips DNS entirely;
+   * prefetching warms the cache before the first one.
+   *
+   * @param host - Host name, e.g. `'example.com'`
+   * @throws Error if `host` is empty
+   */
+  prefetchDns(host: string): void
+
+  /**
+   * Open a connection to `url` ahead of use (DNS, TCP, TLS and the
+   * WebSocket upgrade) and park it in a small process-wide pool
+   *
+   * A later `connect()` with the same URL, protocols and headers, from a
+   * socket with the same CA path and receive buffer size, adopts it and
+   * opens without touching the network. Messages received while parked
+   * are delivered after `onOpen`. Unused connections close after 30 s;
+   * the pool keeps the 4 most recent.
+   *
+   * @param url - WebSocket URL
+   * @param options - Handshake options, as for `connect()`
+   * @throws Error for an invalid URL or options
+   */
+  preconnect(url: string, options?: WebSocketOptions): void
+
+  /**
+   * Smoothed handshake time in milliseconds per endpoint URL, as measured
+   * by every socket in this process. Failed endpoints report 10000 or more
+   * until they succeed again. Persist this to carry measurements across
+   * app launches
+   */
+  getEndpointLatencies(): Record<string, number>
+
+  /**
+   * Seed remembered handshake times, e.g. from a previous session's
+   * `getEndpointLatencies()` (merged, process-wide)
+   */
+  setEndpointLatencies(latencies: Record<string, number>): void
+
+  /**
+   * Publish this socket to other native modules under `name`
+   *
+   * Native code finds it with `NativeSocketRegistry::find(name)` (see
+   * `cpp/NativeSocket.hpp`), then attaches message sinks and sends frames
+   * directly, so native-to-native data never crosses JSI. Sinks run before
+   * the JS callbacks and can consume messages so JS never sees them.
+   *
+   * Re-registering replaces the previous name. The registry holds a weak
+   * reference, so it does not keep the socket alive.
+   */
+  registerNative(name: string): void
+
+  /**
+   * Remove this socket from the native registry (sinks stay attached)
+   */
+  unregisterNative(): void
 }